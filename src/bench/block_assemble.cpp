@@ -73,6 +73,7 @@ static void AssembleBlock(benchmark::State& state)
     CScheduler scheduler;
     {
         ::pblocktree.reset(new CBlockTreeDB(1 << 20, true));
+        ::prctviewTip.reset(new CRingCTViewCache(pblocktree.get()));
         ::pcoinsdbview.reset(new CCoinsViewDB(1 << 23, true));
         ::pcoinsTip.reset(new CCoinsViewCache(pcoinsdbview.get()));
 
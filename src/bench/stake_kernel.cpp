@@ -0,0 +1,44 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <hash.h>
+#include <streams.h>
+#include <uint256.h>
+#include <veil/proofofstake/kernel.h>
+
+// A zerocoin stake is unique by the hash of its serial
+static CDataStream StakeUniqueness()
+{
+    CDataStream ss(SER_GETHASH, 0);
+    ss << uint256S("0x8e4a6f0d4dd2b5cf8a1e7e1fbbb64a3ff10f55f6bd5c46dcc34e4ad5f3f0a7c1");
+    return ss;
+}
+
+// Kernel hash as it was computed before CStakeKernelHasher, reserializing the stream per timestamp
+static void StakeKernelStream(benchmark::State& state)
+{
+    const CDataStream ssUniqueID = StakeUniqueness();
+    const uint64_t nStakeModifier = 0x1234567890abcdef;
+    const unsigned int nTimeBlockFrom = 1571415021;
+    unsigned int nTimeTx = nTimeBlockFrom + 60 * 60;
+    uint256 hashProofOfStake;
+    while (state.KeepRunning()) {
+        CDataStream ss(SER_GETHASH, 0);
+        ss << nStakeModifier << nTimeBlockFrom << ssUniqueID << nTimeTx++;
+        hashProofOfStake = Hash(ss.begin(), ss.end());
+    }
+}
+
+static void StakeKernelMidstate(benchmark::State& state)
+{
+    const CStakeKernelHasher hasher(0x1234567890abcdef, 1571415021, StakeUniqueness());
+    unsigned int nTimeTx = 1571415021 + 60 * 60;
+    uint256 hashProofOfStake;
+    while (state.KeepRunning())
+        hashProofOfStake = hasher.GetHash(nTimeTx++);
+}
+
+BENCHMARK(StakeKernelStream, 1000 * 1000);
+BENCHMARK(StakeKernelMidstate, 1000 * 1000);
@@ -0,0 +1,105 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <key.h>
+#include <pubkey.h>
+#include <veil/ringct/stealth.h>
+#include <veil/ringct/stealthscan.h>
+
+#include <cassert>
+#include <vector>
+
+// Outputs in each scanned block. Each iteration scans this many outputs, so outputs per second is
+// STEALTH_BENCH_OUTPUTS / (time per iteration).
+static const size_t STEALTH_BENCH_OUTPUTS = 16;
+
+static const std::vector<CStealthScanKey>& ScanKeys(size_t nCount)
+{
+    static std::vector<CStealthScanKey> vKeys;
+    if (!secp256k1_ctx_stealth)
+        ECC_Start_Stealth();
+    while (vKeys.size() < nCount) {
+        CStealthScanKey key;
+        key.scan_secret.MakeNewKey(true);
+        SecretToPublicKey(key.scan_secret, key.scan_pubkey);
+        CKey spend_secret;
+        spend_secret.MakeNewKey(true);
+        SecretToPublicKey(spend_secret, key.spend_pubkey);
+        key.idAddress = key.scan_secret.GetPubKey().GetID();
+        vKeys.emplace_back(key);
+    }
+    return vKeys;
+}
+
+// A block of outputs sent to addresses that are never scanned, except for the last one, which goes to the first key
+static const std::vector<CStealthScanOutput>& BlockOutputs()
+{
+    static std::vector<CStealthScanOutput> vOutputs;
+    if (!vOutputs.empty())
+        return vOutputs;
+
+    const std::vector<CStealthScanKey>& vAll = ScanKeys(1000 + STEALTH_BENCH_OUTPUTS - 1);
+    std::vector<CStealthScanKey> vTo(vAll.begin() + 1000, vAll.end());
+    vTo.emplace_back(vAll[0]);
+    for (const CStealthScanKey& key : vTo) {
+        CStealthScanOutput out;
+        CKey sEphem, sShared;
+        ec_point pkSendTo;
+        do {
+            sEphem.MakeNewKey(true);
+        } while (StealthSecret(sEphem, key.scan_pubkey, key.spend_pubkey, sShared, pkSendTo) != 0);
+
+        SecretToPublicKey(sEphem, out.vchEphemPK);
+        out.idDestination = CPubKey(pkSendTo).GetID();
+        vOutputs.emplace_back(out);
+    }
+    return vOutputs;
+}
+
+// Every (output, address) pair through StealthSecret, as was done before ScanStealthOutputs
+static void StealthScanPairs(benchmark::State& state, size_t nAddresses)
+{
+    const std::vector<CStealthScanOutput>& vOutputs = BlockOutputs();
+    const std::vector<CStealthScanKey> vKeys(ScanKeys(nAddresses).begin(), ScanKeys(nAddresses).begin() + nAddresses);
+    CKey sShared;
+    ec_point pkExtracted;
+    while (state.KeepRunning()) {
+        for (const CStealthScanOutput& out : vOutputs) {
+            for (const CStealthScanKey& key : vKeys) {
+                if (StealthSecret(key.scan_secret, out.vchEphemPK, key.spend_pubkey, sShared, pkExtracted) == 0
+                    && CPubKey(pkExtracted).GetID() == out.idDestination) {
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// On one thread, so the numbers are the per-core cost of the scan
+static void StealthScanBlock(benchmark::State& state, size_t nAddresses)
+{
+    const std::vector<CStealthScanOutput>& vOutputs = BlockOutputs();
+    const std::vector<CStealthScanKey> vKeys(ScanKeys(nAddresses).begin(), ScanKeys(nAddresses).begin() + nAddresses);
+    std::vector<int> vMatches;
+    while (state.KeepRunning()) {
+        ScanStealthOutputs(vKeys, vOutputs, vMatches, 1);
+        assert(vMatches.back() == 0);
+    }
+}
+
+static void StealthScanPairs1(benchmark::State& state) { StealthScanPairs(state, 1); }
+static void StealthScanPairs10(benchmark::State& state) { StealthScanPairs(state, 10); }
+static void StealthScanPairs1000(benchmark::State& state) { StealthScanPairs(state, 1000); }
+
+static void StealthScanBlock1(benchmark::State& state) { StealthScanBlock(state, 1); }
+static void StealthScanBlock10(benchmark::State& state) { StealthScanBlock(state, 10); }
+static void StealthScanBlock1000(benchmark::State& state) { StealthScanBlock(state, 1000); }
+
+BENCHMARK(StealthScanPairs1, 800);
+BENCHMARK(StealthScanPairs10, 80);
+BENCHMARK(StealthScanPairs1000, 1);
+BENCHMARK(StealthScanBlock1, 800);
+BENCHMARK(StealthScanBlock10, 80);
+BENCHMARK(StealthScanBlock1000, 1);
@@ -0,0 +1,169 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparams.h>
+#include <chainparamsbase.h>
+#include <libzerocoin/Accumulator.h>
+#include <libzerocoin/Coin.h>
+#include <libzerocoin/CoinSpend.h>
+#include <libzerocoin/Commitment.h>
+#include <libzerocoin/SerialNumberSoK_small.h>
+#include <uint256.h>
+
+#include <memory>
+#include <vector>
+
+using namespace libzerocoin;
+
+// Main net params, built once and shared by all of the zerocoin benchmarks
+static const ZerocoinParams* ZCParams()
+{
+    static std::unique_ptr<CChainParams> chainparams = CreateChainParams(CBaseChainParams::MAIN);
+    return chainparams->Zerocoin_Params();
+}
+
+static const std::vector<PrivateCoin>& Coins(size_t nCount)
+{
+    static std::vector<PrivateCoin> vCoins;
+    while (vCoins.size() < nCount)
+        vCoins.emplace_back(ZCParams(), CoinDenomination::ZQ_TEN, true);
+    return vCoins;
+}
+
+static const std::vector<CBigNum>& PubcoinValues(size_t nCount)
+{
+    static std::vector<CBigNum> vValues;
+    const std::vector<PrivateCoin>& vCoins = Coins(nCount);
+    while (vValues.size() < nCount)
+        vValues.emplace_back(vCoins[vValues.size()].getPublicCoin().getValue());
+    return vValues;
+}
+
+// Serial number proofs as they are checked in a block: one per spend, each on its own commitment and message
+static const std::vector<SerialNumberSoKProof>& SoKProofs(size_t nCount)
+{
+    static std::vector<SerialNumberSoKProof> vProofs;
+    const std::vector<PrivateCoin>& vCoins = Coins(nCount);
+    while (vProofs.size() < nCount) {
+        const PrivateCoin& coin = vCoins[vProofs.size()];
+        const uint256 msghash = CBigNum::randBignum(256).getuint256();
+        Commitment commitment(&ZCParams()->serialNumberSoKCommitmentGroup, coin.getPublicCoin().getValue());
+        SerialNumberSoK_small sig(ZCParams(), coin, commitment, msghash);
+        vProofs.emplace_back(sig, coin.getSerialNumber(), commitment.getCommitmentValue(), msghash);
+    }
+    return vProofs;
+}
+
+static void ZerocoinMint(benchmark::State& state, size_t nCoins)
+{
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < nCoins; i++)
+            PrivateCoin coin(ZCParams(), CoinDenomination::ZQ_TEN, true);
+    }
+}
+
+// Accumulate one value at a time, as was done before batched accumulation
+static void ZerocoinAccumulateSerial(benchmark::State& state, size_t nCoins)
+{
+    const std::vector<CBigNum>& vValues = PubcoinValues(nCoins);
+    while (state.KeepRunning()) {
+        Accumulator accumulator(ZCParams(), CoinDenomination::ZQ_TEN);
+        for (size_t i = 0; i < nCoins; i++)
+            accumulator.increment(vValues[i]);
+    }
+}
+
+static void ZerocoinAccumulateBatch(benchmark::State& state, size_t nCoins)
+{
+    const std::vector<CBigNum>& vAll = PubcoinValues(nCoins);
+    const std::vector<CBigNum> vValues(vAll.begin(), vAll.begin() + nCoins);
+    while (state.KeepRunning()) {
+        Accumulator accumulator(ZCParams(), CoinDenomination::ZQ_TEN);
+        accumulator.increment(vValues);
+    }
+}
+
+// Creating the serial number proof covers the bulletproofs inner product Prove
+static void ZerocoinSoKProve(benchmark::State& state)
+{
+    const PrivateCoin& coin = Coins(1)[0];
+    const uint256 msghash = CBigNum::randBignum(256).getuint256();
+    Commitment commitment(&ZCParams()->serialNumberSoKCommitmentGroup, coin.getPublicCoin().getValue());
+    while (state.KeepRunning())
+        SerialNumberSoK_small sig(ZCParams(), coin, commitment, msghash);
+}
+
+static void ZerocoinSoKVerify(benchmark::State& state)
+{
+    const SerialNumberSoKProof& proof = SoKProofs(1)[0];
+    while (state.KeepRunning())
+        assert(proof.signature.Verify(proof.coinSerialNumber, proof.valueOfCommitmentToCoin, proof.msghash));
+}
+
+static void ZerocoinSoKBatchVerify(benchmark::State& state, size_t nProofs)
+{
+    const std::vector<SerialNumberSoKProof>& vAll = SoKProofs(nProofs);
+    std::vector<const SerialNumberSoKProof*> vProofs;
+    for (size_t i = 0; i < nProofs; i++)
+        vProofs.emplace_back(&vAll[i]);
+    while (state.KeepRunning())
+        assert(SerialNumberSoKProof::BatchVerify(vProofs));
+}
+
+static void ZerocoinSpend(benchmark::State& state)
+{
+    const std::vector<PrivateCoin>& vCoins = Coins(8);
+    const PrivateCoin& coin = vCoins[0];
+    Accumulator accumulator(ZCParams(), CoinDenomination::ZQ_TEN);
+    AccumulatorWitness witness(ZCParams(), accumulator, coin.getPublicCoin());
+    accumulator += coin.getPublicCoin();
+    for (size_t i = 1; i < vCoins.size(); i++) {
+        accumulator += vCoins[i].getPublicCoin();
+        witness += vCoins[i].getPublicCoin();
+    }
+
+    while (state.KeepRunning())
+        CoinSpend spend(ZCParams(), coin, accumulator, uint256(), witness, uint256(), SpendType::SPEND, CoinSpend::V4_LIMP, false);
+}
+
+static void ZerocoinMint1(benchmark::State& state) { ZerocoinMint(state, 1); }
+static void ZerocoinMint8(benchmark::State& state) { ZerocoinMint(state, 8); }
+static void ZerocoinMint32(benchmark::State& state) { ZerocoinMint(state, 32); }
+static void ZerocoinMint128(benchmark::State& state) { ZerocoinMint(state, 128); }
+
+static void ZerocoinAccumulateSerial1(benchmark::State& state) { ZerocoinAccumulateSerial(state, 1); }
+static void ZerocoinAccumulateSerial8(benchmark::State& state) { ZerocoinAccumulateSerial(state, 8); }
+static void ZerocoinAccumulateSerial32(benchmark::State& state) { ZerocoinAccumulateSerial(state, 32); }
+static void ZerocoinAccumulateSerial128(benchmark::State& state) { ZerocoinAccumulateSerial(state, 128); }
+
+static void ZerocoinAccumulateBatch1(benchmark::State& state) { ZerocoinAccumulateBatch(state, 1); }
+static void ZerocoinAccumulateBatch8(benchmark::State& state) { ZerocoinAccumulateBatch(state, 8); }
+static void ZerocoinAccumulateBatch32(benchmark::State& state) { ZerocoinAccumulateBatch(state, 32); }
+static void ZerocoinAccumulateBatch128(benchmark::State& state) { ZerocoinAccumulateBatch(state, 128); }
+
+static void ZerocoinSoKBatchVerify1(benchmark::State& state) { ZerocoinSoKBatchVerify(state, 1); }
+static void ZerocoinSoKBatchVerify8(benchmark::State& state) { ZerocoinSoKBatchVerify(state, 8); }
+static void ZerocoinSoKBatchVerify32(benchmark::State& state) { ZerocoinSoKBatchVerify(state, 32); }
+static void ZerocoinSoKBatchVerify128(benchmark::State& state) { ZerocoinSoKBatchVerify(state, 128); }
+
+BENCHMARK(ZerocoinMint1, 15);
+BENCHMARK(ZerocoinMint8, 2);
+BENCHMARK(ZerocoinMint32, 1);
+BENCHMARK(ZerocoinMint128, 1);
+BENCHMARK(ZerocoinAccumulateSerial1, 500);
+BENCHMARK(ZerocoinAccumulateSerial8, 60);
+BENCHMARK(ZerocoinAccumulateSerial32, 15);
+BENCHMARK(ZerocoinAccumulateSerial128, 4);
+BENCHMARK(ZerocoinAccumulateBatch1, 500);
+BENCHMARK(ZerocoinAccumulateBatch8, 55);
+BENCHMARK(ZerocoinAccumulateBatch32, 15);
+BENCHMARK(ZerocoinAccumulateBatch128, 4);
+BENCHMARK(ZerocoinSoKProve, 1);
+BENCHMARK(ZerocoinSoKVerify, 1);
+BENCHMARK(ZerocoinSoKBatchVerify1, 1);
+BENCHMARK(ZerocoinSoKBatchVerify8, 1);
+BENCHMARK(ZerocoinSoKBatchVerify32, 1);
+BENCHMARK(ZerocoinSoKBatchVerify128, 1);
+BENCHMARK(ZerocoinSpend, 1);
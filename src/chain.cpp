@@ -5,6 +5,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chain.h>
+#include <chainparams.h>
 #include <validation.h>
 #include <hash.h>
 #include <libzerocoin/Denominations.h>
@@ -267,45 +268,43 @@ uint256 CBlockIndex::GetRandomXPoWHash() const
     return GetRandomXBlockHash(GetBlockHeader().nHeight, GetBlockHeader().GetRandomXHeaderHash());
 }
 
+uint256 CBlockIndex::GetModifierPoWHash() const
+{
+    if (!hashModifierPoW.IsNull())
+        return hashModifierPoW;
+    // By using the pindex time and checking it against the PoWUpdateTimestamp we can tell the code to either
+    // set the veildatahash to all zeros if True is passed, or to do nothing if False is passed.
+    // When mining to the local wallet aggressively we have found that occassionaly the memory of the pindex block data
+    // shows that the veildatahash is not zero (0000xxxx). This made the wallet not accept valid PoS blocks from the chain tip
+    // and allowed the wallet to fork off. This fix allows us to pass in the boolean that is used to tell the code
+    // to set the veildatahash to zero manually for us. This can be done only after the PoWUpdateTimestamp as veildatahash isn't used
+    // in the block hash calculation after that timestamp.
+    return GetX16RTPoWHash(nTime >= Params().PowUpdateTimestamp());
+}
+
+bool CBlockIndex::SetModifierPoWHash()
+{
+    if (!IsProofOfWork() || !hashModifierPoW.IsNull())
+        return false;
+    hashModifierPoW = GetModifierPoWHash();
+    return true;
+}
+
 uint256 CBlockIndex::GetProgPowHash(uint256& mix_hash) const
 {
     CBlockHeader header = GetBlockHeader();
     return ProgPowHash(header, mix_hash);
 }
 
-// We are going to be performing a block hash for RandomX. To see if we need to spin up a new
-// cache, we can first check to see if we can use the current validation cache
+// We are going to be performing a block hash for RandomX. Hashes that share the key block of
+// the current validation cache use it, others use one of the recently used caches, so walking
+// historical blocks only spins up one cache per key block.
 uint256 GetRandomXBlockHash(const int32_t& height, const uint256& hash_blob ) {
 
-    char hash[RANDOMX_HASH_SIZE];
-
     // Get the keyblock for the height
     auto temp_keyblock = GetKeyBlock(height);
 
-    // The hash we are calculating is in the same realm at the current validation caches
-    // We don't need to spin up a new cache, as we can use the one already allocated
-    if (temp_keyblock == GetCurrentKeyBlock()) {
-        if (!IsRandomXLightInit()) {
-            InitRandomXLightCache(height);
-        }
-
-        randomx_calculate_hash(GetMyMachineValidating(), &hash_blob, sizeof uint256(), hash);
-        return RandomXHashToUint256(hash);
-    } else {
-        // Create a new temp cache, and machine
-        auto temp_cache = randomx_alloc_cache((randomx_flags)global_randomx_flags);
-        randomx_init_cache(temp_cache, &temp_keyblock, sizeof uint256());
-        auto tempMachine = randomx_create_vm((randomx_flags)global_randomx_flags, temp_cache, NULL);
-
-        // calculate the hash
-        randomx_calculate_hash(tempMachine, &hash_blob, sizeof uint256(), hash);
-
-        // Destroy the vm and cache
-        randomx_destroy_vm(tempMachine);
-        randomx_release_cache(temp_cache);
-
-        // Return the hash
-        return RandomXHashToUint256(hash);
-    }
+    RandomXVMLease vm(temp_keyblock, false);
+    return vm.Hash(hash_blob);
 }
 
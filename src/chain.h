@@ -266,6 +266,11 @@ public:
     //! overhead than an empty uint256
     std::vector<unsigned char> vHashProof;
 
+    //! X16RT hash of a proof of work block, used as stake modifier entropy. Set by SetModifierPoWHash() under cs_main
+    //! when the block index is loaded or the block is connected, before the staker can sample the block; never
+    //! written afterwards, so it may be read without cs_main.
+    uint256 hashModifierPoW;
+
     void SetNull()
     {
         phashBlock = nullptr;
@@ -289,6 +294,7 @@ public:
         //Proof of stake
         fProofOfStake = false;
         vHashProof = {};
+        hashModifierPoW = uint256();
 
         //Proof of Full Node
         fProofOfFullNode = false;
@@ -401,6 +407,10 @@ public:
         return GetBlockHeader().GetX16RTPoWHash(fSetVeilDataHashNull);
     }
 
+    uint256 GetModifierPoWHash() const;
+    //! Fill hashModifierPoW if it is not set yet. Returns true if it was changed.
+    bool SetModifierPoWHash();
+
     uint256 GetProgPowHash(uint256& mix_hash) const;
 
     uint256 GetRandomXPoWHash() const;
@@ -686,6 +696,14 @@ public:
                 return;
             }
         }
+
+        if (!fProofOfStake) {
+            try {
+                READWRITE(hashModifierPoW);
+            } catch (...) {
+                //Could fail since this was added without requiring a reindex
+            }
+        }
     }
 
     uint256 GetBlockHash() const
@@ -276,7 +276,20 @@ bool CheckStandardOutput(CValidationState &state, const Consensus::Params& conse
     return CheckValue(state, p->nValue, nValueOut);
 }
 
-bool CheckBlindOutput(CValidationState &state, const CTxOutCT *p)
+bool CRangeProofCheck::operator()()
+{
+    uint64_t min_value, max_value;
+    int rv = secp256k1_rangeproof_verify(secp256k1_ctx_blind, &min_value, &max_value, pcommitment, pvRangeproof->data(),
+            pvRangeproof->size(), nullptr, 0, secp256k1_generator_h);
+
+    if (rv != 1 && pFirstRejectReason) {
+        const char *pExpected = nullptr;
+        pFirstRejectReason->compare_exchange_strong(pExpected, pRejectReason);
+    }
+    return rv == 1;
+}
+
+bool CheckBlindOutput(CValidationState &state, const CTxOutCT *p, std::vector<CRangeProofCheck> *pvRangeProofChecks)
 {
     if (p->vData.size() < 33 || p->vData.size() > 33 + 5)
         return state.DoS(100, false, REJECT_INVALID, "bad-ctout-ephem-size");
@@ -289,17 +302,18 @@ bool CheckBlindOutput(CValidationState &state, const CTxOutCT *p)
     if (/*todo: fBusyImporting && */ fSkipRangeproof)
         return true;
 
-    uint64_t min_value, max_value;
-    int rv = secp256k1_rangeproof_verify(secp256k1_ctx_blind, &min_value, &max_value, &p->commitment, p->vRangeproof.data(),
-            p->vRangeproof.size(), nullptr, 0, secp256k1_generator_h);
-
-    if (rv != 1)
-        return state.DoS(100, false, REJECT_INVALID, "bad-ctout-rangeproof-verify");
+    CRangeProofCheck check(&p->commitment, &p->vRangeproof, "bad-ctout-rangeproof-verify");
+    if (pvRangeProofChecks) {
+        pvRangeProofChecks->push_back(CRangeProofCheck());
+        check.swap(pvRangeProofChecks->back());
+    } else if (!check()) {
+        return state.DoS(100, false, REJECT_INVALID, check.GetRejectReason());
+    }
 
     return true;
 }
 
-bool CheckAnonOutput(CValidationState &state, const CTxOutRingCT *p)
+bool CheckAnonOutput(CValidationState &state, const CTxOutRingCT *p, std::vector<CRangeProofCheck> *pvRangeProofChecks)
 {
     if (p->vData.size() < 33 || p->vData.size() > 33 + 5)
         return state.DoS(100, false, REJECT_INVALID, "bad-rctout-ephem-size");
@@ -311,12 +325,13 @@ bool CheckAnonOutput(CValidationState &state, const CTxOutRingCT *p)
     if (/* todo: fBusyImporting && */ fSkipRangeproof)
         return true;
 
-    uint64_t min_value, max_value;
-    int rv = secp256k1_rangeproof_verify(secp256k1_ctx_blind, &min_value, &max_value, &p->commitment, p->vRangeproof.data(),
-            p->vRangeproof.size(), nullptr, 0, secp256k1_generator_h);
-
-    if (rv != 1)
-        return state.DoS(100, false, REJECT_INVALID, "bad-rctout-rangeproof-verify");
+    CRangeProofCheck check(&p->commitment, &p->vRangeproof, "bad-rctout-rangeproof-verify");
+    if (pvRangeProofChecks) {
+        pvRangeProofChecks->push_back(CRangeProofCheck());
+        check.swap(pvRangeProofChecks->back());
+    } else if (!check()) {
+        return state.DoS(100, false, REJECT_INVALID, check.GetRejectReason());
+    }
 
     return true;
 }
@@ -333,7 +348,8 @@ bool CheckDataOutput(CValidationState &state, const CTxOutData *p)
     return true;
 }
 
-bool CheckTransaction(const CTransaction& tx, CValidationState &state, bool fSkipZerocoinMintIsPrime)
+bool CheckTransaction(const CTransaction& tx, CValidationState &state, bool fSkipZerocoinMintIsPrime,
+        std::vector<CRangeProofCheck> *pvRangeProofChecks)
 {
     // Basic checks that don't depend on any context
     if (tx.vin.empty())
@@ -374,12 +390,12 @@ bool CheckTransaction(const CTransaction& tx, CValidationState &state, bool fSki
                 break;
             }
             case OUTPUT_CT:
-                if (!CheckBlindOutput(state, (CTxOutCT*) txout.get()))
+                if (!CheckBlindOutput(state, (CTxOutCT*) txout.get(), pvRangeProofChecks))
                     return false;
                 nCTOut++;
                 break;
             case OUTPUT_RINGCT:
-                if (!CheckAnonOutput(state, (CTxOutRingCT*) txout.get()))
+                if (!CheckAnonOutput(state, (CTxOutRingCT*) txout.get(), pvRangeProofChecks))
                     return false;
                 nRingCTOut++;
                 break;
@@ -7,9 +7,12 @@
 
 #include <amount.h>
 
+#include <atomic>
 #include <stdint.h>
 #include <vector>
 
+#include <secp256k1_rangeproof.h>
+
 class CBigNum;
 class CBlockIndex;
 class CCoinsViewCache;
@@ -17,10 +20,43 @@ class CTransaction;
 class CTxOut;
 class CValidationState;
 
+/**
+ * Closure representing one range proof verification of a CT or RingCT output.
+ * Note that this stores references to the output's commitment and proof.
+ */
+class CRangeProofCheck
+{
+private:
+    const secp256k1_pedersen_commitment *pcommitment;
+    const std::vector<uint8_t> *pvRangeproof;
+    const char *pRejectReason;
+    //! If set, receives the reject reason of the first failing check, as the check itself is dropped by a CCheckQueue
+    std::atomic<const char*> *pFirstRejectReason;
+
+public:
+    CRangeProofCheck(): pcommitment(nullptr), pvRangeproof(nullptr), pRejectReason(nullptr), pFirstRejectReason(nullptr) {}
+    CRangeProofCheck(const secp256k1_pedersen_commitment *pcommitmentIn, const std::vector<uint8_t> *pvRangeproofIn, const char *pRejectReasonIn) :
+        pcommitment(pcommitmentIn), pvRangeproof(pvRangeproofIn), pRejectReason(pRejectReasonIn), pFirstRejectReason(nullptr) {}
+
+    bool operator()();
+
+    void swap(CRangeProofCheck &check) {
+        std::swap(pcommitment, check.pcommitment);
+        std::swap(pvRangeproof, check.pvRangeproof);
+        std::swap(pRejectReason, check.pRejectReason);
+        std::swap(pFirstRejectReason, check.pFirstRejectReason);
+    }
+
+    const char *GetRejectReason() const { return pRejectReason; }
+    void SetFirstRejectReason(std::atomic<const char*> *pFirstRejectReasonIn) { pFirstRejectReason = pFirstRejectReasonIn; }
+};
+
 /** Transaction validation functions */
 
 /** Context-independent validity checks */
-bool CheckTransaction(const CTransaction& tx, CValidationState& state, bool fSkipZerocoinMintIsPrime=false);
+/** If pvRangeProofChecks is not nullptr, range proofs are pushed onto it instead of being verified inline. */
+bool CheckTransaction(const CTransaction& tx, CValidationState& state, bool fSkipZerocoinMintIsPrime=false,
+        std::vector<CRangeProofCheck> *pvRangeProofChecks=nullptr);
 bool CheckZerocoinMint(const CTxOut& txout, CBigNum& bnValue, CValidationState& state, bool fSkipZerocoinMintIsPrime);
 bool CheckZerocoinSpend(const CTransaction& tx, CValidationState& state);
 
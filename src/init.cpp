@@ -56,6 +56,7 @@
 #include <veil/invalid.h>
 #include <veil/ringct/anon.h>
 #include <veil/zerocoin/zchain.h>
+#include <veil/workerpool.h>
 
 #ifndef WIN32
 #include <signal.h>
@@ -64,6 +65,7 @@
 #ifdef ENABLE_WALLET
 #include <veil/ringct/anonwallet.h>
 #include "wallet/wallet.h"
+#include "veil/proofofstake/kernel.h"
 #include "pow.h"
 
 #endif
@@ -309,6 +311,7 @@ void Shutdown()
         pcoinsTip.reset();
         pcoinscatcher.reset();
         pcoinsdbview.reset();
+        prctviewTip.reset();
         pblocktree.reset();
         pzerocoinDB.reset();
     }
@@ -443,6 +446,9 @@ void SetupServerArgs()
     gArgs.AddArg("-prune=<n>", strprintf("Reduce storage requirements by enabling pruning (deleting) of old blocks. This allows the pruneblockchain RPC to be called to delete specific blocks, and enables automatic pruning of old blocks if a target size in MiB is provided. This mode is incompatible with -txindex and -rescan. "
             "Warning: Reverting this setting requires re-downloading the entire blockchain. "
             "(default: 0 = disable pruning blocks, 1 = allow manual pruning via RPC, >=%u = automatically prune block files to stay under the specified target size in MiB)", MIN_DISK_SPACE_FOR_BLOCK_FILES / 1024 / 1024), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-randomxvms=<n>", strprintf("Set the number of light-mode RandomX vms used to verify proof of work in parallel (0 = one per script verification thread, default: %d)", DEFAULT_RANDOMX_VALIDATION_VMS), true, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-rctoutputcache=<n>", strprintf("Keep up to <n> megabytes of RingCT outputs in memory for ring member lookups (default: %u)", DEFAULT_RCT_OUTPUT_CACHE), true, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-zerocoinhashindex", strprintf("Keep the hashes of all zerocoin serials and pubcoins in memory, so double spend checks do not read the zerocoin database (default: %u)", DEFAULT_ZEROCOIN_HASH_INDEX), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-reindex-zdb", "Rebuild Zerocoin blockchain database", false, OptionsCategory::OPTIONS);
@@ -453,7 +459,7 @@ void SetupServerArgs()
     hidden_args.emplace_back("-sysperms");
 #endif
     gArgs.AddArg("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX), false, OptionsCategory::OPTIONS);
-    gArgs.AddArg("-threadbatchverify", strprintf("How many threads to run when batch verifying zeroknowledge proofs (default: %u)", DEFAULT_BATCHVERIFY_THREADS), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-threadbatchverify", strprintf("How many threads to run when batch verifying zeroknowledge proofs. Transactions and blocks being validated and blocks being staged each get this many threads (default: %u)", DEFAULT_BATCHVERIFY_THREADS), false, OptionsCategory::OPTIONS);
 
     gArgs.AddArg("-addnode=<ip>", "Add a node to connect to and attempt to keep the connection open (see the `addnode` RPC command help for more info). This option can be specified multiple times to add multiple nodes.", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-banscore=<n>", strprintf("Threshold for disconnecting misbehaving peers (default: %u)", DEFAULT_BANSCORE_THRESHOLD), false, OptionsCategory::CONNECTION);
@@ -1118,6 +1124,11 @@ bool AppInitParameterInteraction()
     else if (nScriptCheckThreads > MAX_SCRIPTCHECK_THREADS)
         nScriptCheckThreads = MAX_SCRIPTCHECK_THREADS;
 
+    int nRandomXVMs = gArgs.GetArg("-randomxvms", DEFAULT_RANDOMX_VALIDATION_VMS);
+    if (nRandomXVMs <= 0)
+        nRandomXVMs = std::max(1, nScriptCheckThreads);
+    SetRandomXValidationVMs(nRandomXVMs);
+
     // block pruning; get the amount of disk space (in MiB) to allot for block & undo files
     int64_t nPruneArg = gArgs.GetArg("-prune", 0);
     if (nPruneArg < 0) {
@@ -1337,10 +1348,25 @@ bool AppInitMain()
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
-        for (int i=0; i<nScriptCheckThreads-1; i++)
+        for (int i=0; i<nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadMLSAGCheck);
+            threadGroup.create_thread(&ThreadRangeProofCheck);
+        }
+    }
+
+    // The thread waiting for the result takes part in the verification as well. Staging gets its own
+    // -threadbatchverify threads, so that it doesn't wait for validation under cs_main or the other way around.
+    int nBatchVerifyThreads = gArgs.GetArg("-threadbatchverify", DEFAULT_BATCHVERIFY_THREADS);
+    for (int i = 0; i < nBatchVerifyThreads - 1; i++) {
+        threadGroup.create_thread(&ThreadSerialNumberSoKCheck);
+        threadGroup.create_thread(&ThreadStagingSoKCheck);
     }
 
+    // The thread calling veil::workerPool.Run() takes part in its tasks as well
+    for (int i = 0; i < GetNumCores() - 1; i++)
+        threadGroup.create_thread(&veil::ThreadWorkerPool);
+
     // Start the lightweight task scheduler thread
     CScheduler::Function serviceLoop = std::bind(&CScheduler::serviceQueue, &scheduler);
     threadGroup.create_thread(std::bind(&TraceThread<CScheduler::Function>, "scheduler", serviceLoop));
@@ -1577,12 +1603,18 @@ bool AppInitMain()
                 pcoinscatcher.reset();
                 // new CBlockTreeDB tries to delete the existing file, which
                 // fails if it's still open from the previous loop. Close it first:
+                prctviewTip.reset();
                 pblocktree.reset();
                 pblocktree.reset(new CBlockTreeDB(nBlockTreeDBCache, false, fReset));
+                prctviewTip.reset(new CRingCTViewCache(pblocktree.get()));
 
                 //zerocoinDB
                 pzerocoinDB.reset();
                 pzerocoinDB.reset(new CZerocoinDB(0, false, fReindex));
+                if (gArgs.GetBoolArg("-zerocoinhashindex", DEFAULT_ZEROCOIN_HASH_INDEX) && !pzerocoinDB->LoadHashIndex()) {
+                    strLoadError = _("Error loading zerocoin database");
+                    break;
+                }
 
                 if (fReset) {
                     pblocktree->WriteReindexing(true);
@@ -1928,8 +1960,12 @@ bool AppInitMain()
         g_wallet_init_interface.Start(scheduler);
 
         //Start staking thread last
-        if (!gArgs.GetBoolArg("-disablewallet", DEFAULT_DISABLE_WALLET) && gArgs.GetBoolArg("-staking", true) && !gArgs.GetBoolArg("-exchangesandservicesmode", false))
+        if (!gArgs.GetBoolArg("-disablewallet", DEFAULT_DISABLE_WALLET) && gArgs.GetBoolArg("-staking", true) && !gArgs.GetBoolArg("-exchangesandservicesmode", false)) {
             threadGroupStaking.create_thread(&ThreadStakeMiner);
+            // The staking thread searches for a kernel along with these
+            for (int i = 0; i < gArgs.GetArg("-stakingthreads", DEFAULT_STAKING_THREADS) - 1; i++)
+                threadGroupStaking.create_thread(&ThreadStakeKernelSearch);
+        }
 
         // Link thread groups
         LinkAutoSpendThreadGroup(&threadGroupAutoSpend);
@@ -13,6 +13,7 @@
 
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 #include "Accumulator.h"
 #include "ZerocoinDefines.h"
 
@@ -46,6 +47,21 @@ void Accumulator::increment(const CBigNum& bnValue) {
     this->value = this->value.pow_mod(bnValue, this->params->accumulatorModulus);
 }
 
+void Accumulator::increment(const std::vector<CBigNum>& vValues, size_t nBatchSize) {
+    if (nBatchSize == 0)
+        nBatchSize = 1;
+
+    // Multiply each chunk of values into one exponent so that a chunk costs a
+    // single pow_mod instead of one per value
+    for (size_t i = 0; i < vValues.size(); i += nBatchSize) {
+        size_t nEnd = std::min(vValues.size(), i + nBatchSize);
+        CBigNum bnExponent = vValues[i];
+        for (size_t j = i + 1; j < nEnd; j++)
+            bnExponent *= vValues[j];
+        increment(bnExponent);
+    }
+}
+
 bool Accumulator::accumulate(const PublicCoin& coin) {
     // Make sure we're initialized
     if(!(this->value))
@@ -62,6 +62,17 @@ public:
     bool accumulate(const PublicCoin &coin);
     void increment(const CBigNum& bnValue);
 
+    /**
+     * Accumulate several raw coin values at once. Since acc^(a*b) = (acc^a)^b,
+     * up to nBatchSize values are multiplied into one exponent and applied with a
+     * single modular exponentiation. The result is identical to calling
+     * increment() for each value in turn. No validation is performed.
+     *
+     * @param vValues       the coin values to accumulate
+     * @param nBatchSize    the number of values combined per exponentiation
+     */
+    void increment(const std::vector<CBigNum>& vValues, size_t nBatchSize = ACCUMULATOR_BATCH_SIZE);
+
     CoinDenomination getDenomination() const;
     /** Get the accumulator result
      *
@@ -39,7 +39,7 @@ void Bulletproofs::Prove(const CBN_matrix ck_inner_g,
     hasher << u_inner_prod.ToString() << P_inner_prod.ToString() << z.ToString();
     CBigNum pre = CBigNum(hasher.GetHash()) % q;
 
-    CBigNum u_inner = u_inner_prod.pow_mod(pre,p);
+    CBigNum u_inner = params->serialNumberSoKCommitmentGroup.pow_u_inner(pre);
 
     // Starting the actual protocol
     CBN_matrix a_sets2 = splitIntoSets(a_sets, s);
@@ -137,7 +137,7 @@ bool Bulletproofs::Verify(const ZerocoinParams* ZCp,
     hasher << u_inner_prod.ToString() << P_inner_prod.ToString() << z.ToString();
     CBigNum x1 = CBigNum(hasher.GetHash()) % q;
 
-    CBigNum u_inner = u_inner_prod.pow_mod(x1,p);
+    CBigNum u_inner = params->serialNumberSoKCommitmentGroup.pow_u_inner(x1);
     CBigNum P_inner = P_inner_prod.mul_mod(u_inner.pow_mod(z,p),p);
 
     // Starting the actual protocol
@@ -31,6 +31,11 @@ ZerocoinParams::ZerocoinParams(CBigNum N, uint32_t securityLevel) {
     ArithmeticCircuit::setPreConstraints(this, ZKP_wA, ZKP_wB, ZKP_wC, ZKP_K);
     ArithmeticCircuit::set_s_poly(this, S_POLY_A1, S_POLY_A2, S_POLY_B1, S_POLY_B2, S_POLY_C1, S_POLY_C2);
 
+    // Precompute the powers of the generators used by commitments and proofs
+    this->coinCommitmentGroup.Precompute();
+    this->serialNumberSoKCommitmentGroup.Precompute();
+    this->accumulatorParams.accumulatorPoKCommitmentGroup.Precompute();
+
     this->accumulatorParams.initialized = true;
     this->initialized = true;
 }
@@ -49,7 +54,67 @@ CBigNum IntegerGroupParams::randomElement() const {
     // The generator of the group raised
     // to a random number less than the order of the group
     // provides us with a uniformly distributed random number.
-    return this->g.pow_mod(CBigNum::randBignum(this->groupOrder),this->modulus);
+    return pow_g(CBigNum::randBignum(this->groupOrder));
+}
+
+CBigNum IntegerGroupParams::pow_g(const CBigNum& e) const {
+    return tableG ? tableG->pow_mod(e) : this->g.pow_mod(e, this->modulus);
+}
+
+CBigNum IntegerGroupParams::pow_h(const CBigNum& e) const {
+    return tableH ? tableH->pow_mod(e) : this->h.pow_mod(e, this->modulus);
+}
+
+CBigNum IntegerGroupParams::pow_u_inner(const CBigNum& e) const {
+    return tableU ? tableU->pow_mod(e) : this->u_inner_prod.pow_mod(e, this->modulus);
+}
+
+void IntegerGroupParams::Precompute() {
+#if ZEROCOIN_FIXED_BASE_TABLES
+    if (this->groupOrder <= 0 || this->modulus <= 0)
+        return;
+    this->tableG = std::make_shared<const FixedBaseTable>(this->g, this->modulus, this->groupOrder);
+    this->tableH = std::make_shared<const FixedBaseTable>(this->h, this->modulus, this->groupOrder);
+    if (this->u_inner_prod != 0)
+        this->tableU = std::make_shared<const FixedBaseTable>(this->u_inner_prod, this->modulus, this->groupOrder);
+#endif
+}
+
+FixedBaseTable::FixedBaseTable(const CBigNum& base, const CBigNum& modulus, const CBigNum& order) :
+        modulus(modulus), order(order) {
+    const int nDigits = (1 << WINDOW_BITS) - 1;
+    const int nRows = (order.bitSize() + WINDOW_BITS - 1) / WINDOW_BITS;
+
+    // Row i holds rowBase^1 .. rowBase^15 where rowBase = base^(16^i)
+    CBigNum rowBase = base % modulus;
+    vRows.resize(nRows);
+    for (int i = 0; i < nRows; i++) {
+        CBN_vector& row = vRows[i];
+        row.resize(nDigits);
+        row[0] = rowBase;
+        for (int d = 1; d < nDigits; d++)
+            row[d] = row[d - 1].mul_mod(rowBase, modulus);
+        rowBase = row[nDigits - 1].mul_mod(rowBase, modulus);
+    }
+}
+
+CBigNum FixedBaseTable::pow_mod(const CBigNum& e) const {
+    // Reduce into [0, order), which also takes care of negative exponents
+    const CBigNum exp = e % order;
+    CBigNum result = CBigNum(1);
+
+    // getvch() is little endian, so byte k holds the digits 2k (low nibble) and 2k+1 (high nibble)
+    std::vector<unsigned char> vch = exp.getvch();
+    for (unsigned int k = 0; k < vch.size(); k++) {
+        int digitLow = vch[k] & 0x0f;
+        int digitHigh = vch[k] >> 4;
+        if (digitLow)
+            result = result.mul_mod(vRows[2 * k][digitLow - 1], modulus);
+        if (digitHigh)
+            result = result.mul_mod(vRows[2 * k + 1][digitHigh - 1], modulus);
+    }
+
+    return result;
 }
 
 } /* namespace libzerocoin */
@@ -17,8 +17,36 @@
 #include "bignum.h"
 #include "ZerocoinDefines.h"
 
+#include <memory>
+
 namespace libzerocoin {
 
+/**
+ * Precomputed powers of a fixed base for fast exponentiation.
+ *
+ * For every 4-bit digit position i of the exponent the table holds base^(d*16^i) for d = 1..15, so that
+ * base^e is the product of one table entry per nonzero digit of e and no squarings are needed.
+ * Exponents are reduced modulo the order of the base first.
+ */
+class FixedBaseTable {
+public:
+	/**
+	 * @param base      the fixed base
+	 * @param modulus   the modulus of the group
+	 * @param order     the order of base in the group, i.e. base^order mod modulus = 1
+	 */
+	FixedBaseTable(const CBigNum& base, const CBigNum& modulus, const CBigNum& order);
+
+	/** @return base^e mod modulus */
+	CBigNum pow_mod(const CBigNum& e) const;
+
+private:
+	static const int WINDOW_BITS = 4;
+	CBigNum modulus;
+	CBigNum order;
+	std::vector<CBN_vector> vRows;
+};
+
 class IntegerGroupParams {
 public:
 	/** @brief Integer group class, default constructor
@@ -32,6 +60,23 @@ public:
 	 * @return a random element in the group.
 	 */
 	CBigNum randomElement() const;
+
+	/**
+	 * Exponentiation of the group generators g, h and u_inner_prod modulo the group's modulus.
+	 * Uses the tables built by Precompute() when they are available.
+	 * @param e the exponent
+	 * @return g^e, h^e or u_inner_prod^e mod modulus
+	 */
+	CBigNum pow_g(const CBigNum& e) const;
+	CBigNum pow_h(const CBigNum& e) const;
+	CBigNum pow_u_inner(const CBigNum& e) const;
+
+	/**
+	 * Build the fixed-base tables for the generators. Only valid for groups where
+	 * the generators have order groupOrder.
+	 */
+	void Precompute();
+
 	bool initialized;
 
 	/**
@@ -78,6 +123,11 @@ public:
 		    READWRITE(modulus);
 		    READWRITE(groupOrder);
 	}	
+
+private:
+	std::shared_ptr<const FixedBaseTable> tableG;
+	std::shared_ptr<const FixedBaseTable> tableH;
+	std::shared_ptr<const FixedBaseTable> tableU;
 };
 
 class AccumulatorAndProofParams {
@@ -798,7 +798,7 @@ bool SerialNumberSoKProof::BatchBulletproofs(const CBN_matrix ck_inner_g, std::v
         hasher << u_inner_prod.ToString() << P_inner_prod.ToString() << z.ToString();
         x1 = CBigNum(hasher.GetHash()) % q;
 
-        u_inner = u_inner_prod.pow_mod(x1,p);
+        u_inner = params->serialNumberSoKCommitmentGroup.pow_u_inner(x1);
         P_inner = P_inner_prod.mul_mod(u_inner.pow_mod(z,p),p);
 
         // Starting the actual protocol
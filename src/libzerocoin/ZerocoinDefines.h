@@ -38,6 +38,15 @@
 // to timing attacks. Turn off if an attacker can measure coin minting time.
 #define	ZEROCOIN_FAST_MINT 1
 
+// Precomputes tables of the powers of the fixed group generators for faster exponentiation.
+// The table lookups depend on the exponent, so turn off if an attacker can measure proof times.
+#define ZEROCOIN_FIXED_BASE_TABLES 1
+
+// Number of coin values multiplied into a single exponent when a batch of coins
+// is accumulated at once. Larger batches mean fewer modular exponentiations but
+// a longer exponent for each of them.
+#define ACCUMULATOR_BATCH_SIZE              16
+
 /** Parameters used in the new protocol.
  *  !TODO: move where appropriate
  */
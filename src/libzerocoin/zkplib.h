@@ -87,7 +87,7 @@ inline CBigNum pedersenCommitment(const ZerocoinParams* ZCparams,
     CBigNum C = CBigNum(1);
     for(unsigned int i=0; i<g_blinders.size(); i++)
         C = C.mul_mod((SoKgroup->gis[i]).pow_mod(g_blinders[i],p),p);
-    C = C.mul_mod((SoKgroup->h).pow_mod(h_blinder,p),p);
+    C = C.mul_mod(SoKgroup->pow_h(h_blinder),p);
 
     return C;
 }
@@ -12,6 +12,11 @@
 #include <tinyformat.h>
 #include <boost/thread.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+
 // ProgPow
 #include <crypto/ethash/lib/ethash/endianness.hpp>
 
@@ -34,9 +39,101 @@ bool fKeyBlockedChanged = false;
 // Used by Validator
 CCriticalSection cs_randomx_validator;
 static uint256 validation_key_block;
-static randomx_cache *myCacheValidating;
-static randomx_vm *myMachineValidating;
 static bool fLightCacheInited = false;
+static std::atomic<int> nMaxValidatingVMs(1);
+
+/**
+ * A light-mode RandomX cache for one key block, together with the pool of VMs that
+ * were created on top of it. VMs are handed out through RandomXVMLease, so several
+ * threads can hash with the same key block at once. The cache and its VMs are
+ * released once the last lease that refers to it goes away.
+ */
+struct RandomXValidationContext
+{
+    const uint256 key_block;
+    randomx_cache* cache;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<randomx_vm*> vIdle;
+    int nVMs;
+
+    explicit RandomXValidationContext(const uint256& key) : key_block(key), nVMs(0)
+    {
+        cache = randomx_alloc_cache((randomx_flags)global_randomx_flags);
+        randomx_init_cache(cache, &key_block, sizeof uint256());
+    }
+
+    ~RandomXValidationContext()
+    {
+        // All leases hold a reference to the context, so every vm is idle by now
+        assert((int)vIdle.size() == nVMs);
+        for (randomx_vm* vm : vIdle)
+            randomx_destroy_vm(vm);
+        randomx_release_cache(cache);
+    }
+
+    randomx_vm* Acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (vIdle.empty() && nVMs >= nMaxValidatingVMs)
+            cond.wait(lock);
+
+        if (!vIdle.empty()) {
+            randomx_vm* vm = vIdle.back();
+            vIdle.pop_back();
+            return vm;
+        }
+
+        int nVM = ++nVMs;
+        lock.unlock();
+        LogPrintf("%s: Spinning up validation vm %d for key block: %s\n", __func__, nVM, key_block.GetHex());
+        return randomx_create_vm_timed((randomx_flags)global_randomx_flags, cache, NULL, true);
+    }
+
+    void Release(randomx_vm* vm)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            vIdle.push_back(vm);
+        }
+        cond.notify_one();
+    }
+};
+
+static std::shared_ptr<RandomXValidationContext> pValidationContext;
+
+// Recently used caches, most recent first. Keeps off-epoch hashes (reorgs, rpc, reindex)
+// from rebuilding a cache for every block.
+static std::list<std::shared_ptr<RandomXValidationContext>> lruValidationContexts;
+
+static std::shared_ptr<RandomXValidationContext> GetValidationContext(const uint256& key_block) EXCLUSIVE_LOCKS_REQUIRED(cs_randomx_validator)
+{
+    for (auto it = lruValidationContexts.begin(); it != lruValidationContexts.end(); ++it) {
+        if ((*it)->key_block == key_block) {
+            lruValidationContexts.splice(lruValidationContexts.begin(), lruValidationContexts, it);
+            return lruValidationContexts.front();
+        }
+    }
+
+    global_randomx_flags = (int)randomx_get_flags();
+    LogPrintf("%s: Spinning up a new cache for key block: %s\n", __func__, key_block.GetHex());
+    lruValidationContexts.push_front(std::make_shared<RandomXValidationContext>(key_block));
+
+    // Never evict the cache of the current validation key block
+    while (lruValidationContexts.size() > MAX_RANDOMX_VALIDATION_CACHES) {
+        auto itEvict = std::prev(lruValidationContexts.end());
+        if (*itEvict == pValidationContext)
+            itEvict = std::prev(itEvict);
+        lruValidationContexts.erase(itEvict);
+    }
+    return lruValidationContexts.front();
+}
+
+void SetRandomXValidationVMs(int nVMs)
+{
+    nMaxValidatingVMs = std::max(1, nVMs);
+}
 
 bool IsRandomXLightInit()
 {
@@ -50,12 +147,7 @@ void InitRandomXLightCache(const int32_t& height) {
         return;
 
     validation_key_block = GetKeyBlock(height);
-
-    global_randomx_flags = (int)randomx_get_flags();
-    myCacheValidating = randomx_alloc_cache((randomx_flags)global_randomx_flags);
-    randomx_init_cache(myCacheValidating, &validation_key_block, sizeof uint256());
-    LogPrintf("%s: Spinning up a new vm at new block height: %d\n", __func__, height);
-    myMachineValidating = randomx_create_vm_timed((randomx_flags)global_randomx_flags, myCacheValidating, NULL, true);
+    pValidationContext = GetValidationContext(validation_key_block);
     fLightCacheInited = true;
 }
 
@@ -63,23 +155,16 @@ void KeyBlockChanged(const uint256& new_block) {
     LOCK(cs_randomx_validator);
     validation_key_block = new_block;
 
-    DeallocateRandomXLightCache();
-    myCacheValidating = randomx_alloc_cache((randomx_flags)global_randomx_flags);
-    randomx_init_cache(myCacheValidating, &validation_key_block, sizeof uint256());
-    LogPrintf("%s: Spinning up a new vm at new block: %s\n", __func__, new_block.GetHex());
-    myMachineValidating = randomx_create_vm_timed((randomx_flags)global_randomx_flags, myCacheValidating, NULL, true);
+    // The previous cache stays in the lru, so a reorg across the key change doesn't rebuild it
+    pValidationContext = GetValidationContext(validation_key_block);
     fLightCacheInited = true;
 }
 
 uint256 GetCurrentKeyBlock() {
-
+    LOCK(cs_randomx_validator);
     return validation_key_block;
 }
 
-randomx_vm* GetMyMachineValidating() {
-    return myMachineValidating;
-}
-
 randomx_flags GetRandomXFlags() {
     return (randomx_flags)global_randomx_flags;
 }
@@ -92,30 +177,49 @@ bool CheckIfMiningKeyShouldChange(const uint256& check_block)
 void CheckIfValidationKeyShouldChangeAndUpdate(const uint256& check_block)
 {
     LOCK(cs_randomx_validator);
-    if (check_block != validation_key_block)
+    if (check_block != validation_key_block || !fLightCacheInited)
         KeyBlockChanged(check_block);
 }
 
 void DeallocateRandomXLightCache() {
     LOCK(cs_randomx_validator);
+    lruValidationContexts.clear();
     if (!fLightCacheInited) {
         LogPrintf("%s: Return because light cache isn't inited\n", __func__);
         return;
     }
 
-    if (myMachineValidating) {
-        LogPrintf("%s: Releasing the vm\n",__func__);
-        randomx_destroy_vm(myMachineValidating);
-        myMachineValidating = nullptr;
-    }
+    // Vms that are still leased keep the old cache alive until they are returned
+    LogPrintf("%s: Releasing the validating cache\n",__func__);
+    pValidationContext.reset();
 
-    if (myCacheValidating) {
-        LogPrintf("%s: Releasing the validating cache\n",__func__);
-        randomx_release_cache(myCacheValidating);
-        myCacheValidating = nullptr;
+    fLightCacheInited = false;
+}
+
+RandomXVMLease::RandomXVMLease(const uint256& key_block, bool fSwitchKey)
+{
+    {
+        LOCK(cs_randomx_validator);
+        if (fSwitchKey) {
+            CheckIfValidationKeyShouldChangeAndUpdate(key_block);
+            context = pValidationContext;
+        } else {
+            context = GetValidationContext(key_block);
+        }
     }
+    vm = context->Acquire();
+}
 
-    fLightCacheInited = false;
+RandomXVMLease::~RandomXVMLease()
+{
+    context->Release(vm);
+}
+
+uint256 RandomXVMLease::Hash(const uint256& hash_blob) const
+{
+    char hash[RANDOMX_HASH_SIZE];
+    randomx_calculate_hash(vm, &hash_blob, sizeof uint256(), hash);
+    return RandomXHashToUint256(hash);
 }
 
 arith_uint256 GetPowLimit(int nPoWType)
@@ -412,6 +516,7 @@ bool CheckProofOfWork(uint256 hash, unsigned int nBits, const Consensus::Params&
 
 uint256 GetKeyBlock(const uint32_t& nHeight)
 {
+    LOCK(cs_randomx_validator);
     static uint256 current_key_block = uint256();
 
     uint32_t checkMultiplier = 0;
@@ -437,12 +542,6 @@ uint256 GetKeyBlock(const uint32_t& nHeight)
 
 bool CheckRandomXProofOfWork(const CBlockHeader& block, unsigned int nBits, const Consensus::Params& params)
 {
-    LOCK(cs_randomx_validator);
-    InitRandomXLightCache(block.nHeight);
-
-    // This will check if the key block needs to change and will take down the cache and vm, and spin up the new ones
-    CheckIfValidationKeyShouldChangeAndUpdate(GetKeyBlock(block.nHeight));
-
     // Create the eth_boundary from the nBits
     arith_uint256 bnTarget;
     bool fNegative;
@@ -455,13 +554,10 @@ bool CheckRandomXProofOfWork(const CBlockHeader& block, unsigned int nBits, cons
         return false;
     }
 
-    uint256 hash_blob = block.GetRandomXHeaderHash();
-
-    char hash[RANDOMX_HASH_SIZE];
-
-    randomx_calculate_hash(GetMyMachineValidating(), &hash_blob, sizeof uint256(), hash);
-
-    uint256 nHash = RandomXHashToUint256(hash);
+    // This will check if the key block needs to change and will take down the cache, and spin up the new one.
+    // The lease is only serialized with other validators while a vm is handed out, not while hashing.
+    RandomXVMLease vm(GetKeyBlock(block.nHeight));
+    uint256 nHash = vm.Hash(block.GetRandomXHeaderHash());
 
     // Check proof of work matches claimed amount
     return UintToArith256(nHash) < bnTarget;
@@ -20,6 +20,12 @@ class randomx_vm;
 class randomx_dataset;
 class randomx_cache;
 class CReserveScript;
+struct RandomXValidationContext;
+
+/** Default for -randomxvms, the number of light-mode RandomX vms used for validation (0 = one per script check thread) */
+static const int DEFAULT_RANDOMX_VALIDATION_VMS = 0;
+/** Maximum number of RandomX light caches (one per key block) kept in memory for validation */
+static const size_t MAX_RANDOMX_VALIDATION_CACHES = 3;
 
 extern std::vector<randomx_vm*> vecRandomXVM;
 extern bool fKeyBlockedChanged;
@@ -41,7 +47,29 @@ void CheckIfValidationKeyShouldChangeAndUpdate(const uint256& check_block);
 void DeallocateRandomXLightCache();
 uint256 GetCurrentKeyBlock();
 uint256 GetKeyBlock(const uint32_t& nHeight);
-randomx_vm* GetMyMachineValidating();
+void SetRandomXValidationVMs(int nVMs);
+
+/**
+ * Lease of a light-mode RandomX vm from the validation pool for the given key block.
+ * Vms are shared by all validating threads, and the vm is returned to the pool when
+ * the lease goes out of scope. With fSwitchKey the key block becomes the current
+ * validation key, otherwise the vm comes from the lru of recently used caches.
+ */
+class RandomXVMLease
+{
+private:
+    std::shared_ptr<RandomXValidationContext> context;
+    randomx_vm* vm;
+
+public:
+    explicit RandomXVMLease(const uint256& key_block, bool fSwitchKey = true);
+    ~RandomXVMLease();
+
+    RandomXVMLease(const RandomXVMLease&) = delete;
+    RandomXVMLease& operator=(const RandomXVMLease&) = delete;
+
+    uint256 Hash(const uint256& hash_blob) const;
+};
 
 /** Check whether a block hash satisfies the randomx-proof-of-work requirement specified by nBits */
 bool CheckRandomXProofOfWork(const CBlockHeader& block, unsigned int nBits, const Consensus::Params&);
@@ -235,7 +235,7 @@ UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGen
             }
             pblock->mixHash = mix_hash;
         } else if (pblock->IsRandomX() && pblock->nTime >= Params().PowUpdateTimestamp()) {
-            char hash[RANDOMX_HASH_SIZE];
+            RandomXVMLease vm(GetKeyBlock(pblock->nHeight));
 
             arith_uint256 bnTarget;
             bool fNegative;
@@ -245,10 +245,7 @@ UniValue generateBlocks(std::shared_ptr<CReserveScript> coinbaseScript, int nGen
 
             while (nMaxTries > 0 && pblock->nNonce < nInnerLoopCount && !ShutdownRequested()) {
                 // RandomX hash
-                uint256 hash_blob = pblock->GetRandomXHeaderHash();
-                randomx_calculate_hash(GetMyMachineValidating(), &hash_blob, sizeof uint256(), hash);
-
-                uint256 uint256Hash = RandomXHashToUint256(hash);
+                uint256 uint256Hash = vm.Hash(pblock->GetRandomXHeaderHash());
 
                 // Check proof of work matches claimed amount
                 if (UintToArith256(uint256Hash) < bnTarget)
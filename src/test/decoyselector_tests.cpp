@@ -0,0 +1,109 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veil/ringct/decoyselector.h>
+
+#include <primitives/transaction.h>
+#include <test/test_veil.h>
+#include <veil/invalid.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(decoyselector_tests, BasicTestingSetup)
+
+static void AddOutputs(veil::DecoySelector& selector, int64_t nLast, std::vector<COutPoint>& vOutPoints)
+{
+    for (int64_t i = selector.LastIndex() + 1; i <= nLast; i++) {
+        vOutPoints.emplace_back(InsecureRand256(), 0);
+        BOOST_CHECK(selector.Add(i, vOutPoints.back()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(decoyselector_count_pick_bounds)
+{
+    veil::DecoySelector selector;
+    std::vector<COutPoint> vOutPoints;
+    BOOST_CHECK_EQUAL(selector.Count(1, 100), 0U);
+    BOOST_CHECK_EQUAL(selector.Pick(1, 100), -1);
+
+    AddOutputs(selector, 100, vOutPoints);
+    BOOST_CHECK_EQUAL(selector.LastIndex(), 100);
+
+    // Outputs are added in index order only
+    BOOST_CHECK(!selector.Add(100, vOutPoints.back()));
+    BOOST_CHECK(!selector.Add(102, vOutPoints.back()));
+    BOOST_CHECK_EQUAL(selector.LastIndex(), 100);
+
+    BOOST_CHECK_EQUAL(selector.Count(1, 100), 100U);
+    BOOST_CHECK_EQUAL(selector.Count(0, 1000), 100U);
+    BOOST_CHECK_EQUAL(selector.Count(10, 19), 10U);
+    BOOST_CHECK_EQUAL(selector.Count(50, 50), 1U);
+    BOOST_CHECK_EQUAL(selector.Count(51, 50), 0U);
+    BOOST_CHECK_EQUAL(selector.Count(101, 200), 0U);
+    BOOST_CHECK_EQUAL(selector.Pick(101, 200), -1);
+    BOOST_CHECK_EQUAL(selector.Pick(51, 50), -1);
+    BOOST_CHECK_EQUAL(selector.Pick(50, 50), 50);
+
+    // Both ends of the range can be picked, nothing outside of it
+    bool fMin = false, fMax = false;
+    for (int i = 0; i < 1000; i++) {
+        int64_t nPick = selector.Pick(10, 12);
+        BOOST_CHECK(nPick >= 10 && nPick <= 12);
+        fMin |= nPick == 10;
+        fMax |= nPick == 12;
+    }
+    BOOST_CHECK(fMin && fMax);
+}
+
+BOOST_AUTO_TEST_CASE(decoyselector_blacklist)
+{
+    veil::DecoySelector selector;
+    std::vector<COutPoint> vOutPoints;
+    AddOutputs(selector, 10, vOutPoints);
+
+    // Blacklisted outputs take an index, but are never picked
+    for (int64_t i = 11; i <= 20; i++) {
+        vOutPoints.emplace_back(InsecureRand256(), 0);
+        if (i % 2 == 0)
+            blacklist::AddRctOutPoint(vOutPoints.back());
+        BOOST_CHECK(selector.Add(i, vOutPoints.back()));
+    }
+    BOOST_CHECK_EQUAL(selector.LastIndex(), 20);
+    BOOST_CHECK_EQUAL(selector.Count(1, 20), 15U);
+    BOOST_CHECK_EQUAL(selector.Count(12, 12), 0U);
+    BOOST_CHECK_EQUAL(selector.Pick(12, 12), -1);
+    for (int i = 0; i < 200; i++) {
+        int64_t nPick = selector.Pick(11, 20);
+        BOOST_CHECK(nPick >= 11 && nPick <= 20 && nPick % 2 == 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(decoyselector_rewind)
+{
+    veil::DecoySelector selector;
+    std::vector<COutPoint> vOutPoints;
+    AddOutputs(selector, 50, vOutPoints);
+
+    // Rewinding to the last output of the fork point drops the outputs of the disconnected blocks
+    selector.Rewind(30);
+    BOOST_CHECK_EQUAL(selector.LastIndex(), 30);
+    BOOST_CHECK_EQUAL(selector.Count(1, 50), 30U);
+    BOOST_CHECK_EQUAL(selector.Pick(31, 50), -1);
+
+    // Rewinding past the end does nothing
+    selector.Rewind(40);
+    BOOST_CHECK_EQUAL(selector.LastIndex(), 30);
+
+    // The outputs of the new blocks continue from the fork point
+    BOOST_CHECK(!selector.Add(51, vOutPoints.back()));
+    AddOutputs(selector, 45, vOutPoints);
+    BOOST_CHECK_EQUAL(selector.LastIndex(), 45);
+    BOOST_CHECK_EQUAL(selector.Count(1, 50), 45U);
+
+    selector.Rewind(0);
+    BOOST_CHECK_EQUAL(selector.LastIndex(), 0);
+    BOOST_CHECK_EQUAL(selector.Count(0, 100), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
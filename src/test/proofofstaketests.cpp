@@ -17,6 +17,7 @@
 #include <script/standard.h>
 #include <key_io.h>
 #include <veil/zerocoin/accumulators.h>
+#include <veil/proofofstake/kernel.h>
 
 
 BOOST_FIXTURE_TEST_SUITE(proofofstake_tests, BasicTestingSetup)
@@ -151,4 +152,20 @@ BOOST_AUTO_TEST_CASE(proofofstake_block)
 
 }
 
+BOOST_AUTO_TEST_CASE(stake_kernel_hasher)
+{
+    CDataStream ssUniqueID(SER_GETHASH, 0);
+    ssUniqueID << InsecureRand256();
+    const uint64_t nStakeModifier = InsecureRandBits(64);
+    const unsigned int nTimeBlockFrom = 1571415021;
+
+    // The midstate hasher has to match hashing the whole kernel stream for every timestamp
+    CStakeKernelHasher hasher(nStakeModifier, nTimeBlockFrom, ssUniqueID);
+    for (unsigned int nTimeTx = nTimeBlockFrom; nTimeTx < nTimeBlockFrom + 100; nTimeTx++) {
+        CDataStream ss(SER_GETHASH, 0);
+        ss << nStakeModifier << nTimeBlockFrom << ssUniqueID << nTimeTx;
+        BOOST_CHECK(hasher.GetHash(nTimeTx) == Hash(ss.begin(), ss.end()));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -20,6 +20,8 @@
 #include "crypto/randomx/aes_hash.hpp"
 #include "crypto/randomx/utility.hpp"
 
+#include <pow.h>
+
 #include <array>
 
 BOOST_FIXTURE_TEST_SUITE(randomx_tests, BasicTestingSetup)
@@ -1208,4 +1210,49 @@ BOOST_AUTO_TEST_CASE(randomx_run_tests)
 
 
 
+BOOST_AUTO_TEST_CASE(randomx_validation_cache_lease)
+{
+    const uint256 key1 = uint256S("0011223344556677889900112233445566778899001122334455667788990011");
+    const uint256 key2 = uint256S("aabbcceeffaabbcceeffaabbcceeffaabbcceeffaabbcceeffaabbcceeffaabb");
+    const uint256 hash_blob = uint256S("1234567890abcdef1234567890abcdef1234567890abcdef1234567890abcdef");
+
+    auto ExpectedHash = [&](const uint256& key) {
+        char hash[RANDOMX_HASH_SIZE];
+        randomx_flags flags = randomx_get_flags();
+        randomx_cache *myCache = randomx_alloc_cache(flags);
+        randomx_init_cache(myCache, &key, sizeof uint256());
+        randomx_vm *myMachine = randomx_create_vm(flags, myCache, NULL);
+        randomx_calculate_hash(myMachine, &hash_blob, sizeof uint256(), hash);
+        randomx_destroy_vm(myMachine);
+        randomx_release_cache(myCache);
+        return RandomXHashToUint256(hash);
+    };
+
+    SetRandomXValidationVMs(2);
+
+    uint256 hash1, hash2;
+    {
+        // Two leases of the same key block are served by separate vms
+        RandomXVMLease vm1(key1, false);
+        RandomXVMLease vm2(key1, false);
+        hash1 = vm1.Hash(hash_blob);
+        BOOST_CHECK(vm2.Hash(hash_blob) == hash1);
+    }
+    {
+        RandomXVMLease vm(key2, false);
+        hash2 = vm.Hash(hash_blob);
+    }
+    {
+        // Going back to the first key block reuses its cache
+        RandomXVMLease vm(key1, false);
+        BOOST_CHECK(vm.Hash(hash_blob) == hash1);
+    }
+
+    BOOST_CHECK(hash1 != hash2);
+    BOOST_CHECK(hash1 == ExpectedHash(key1));
+    BOOST_CHECK(hash2 == ExpectedHash(key2));
+
+    DeallocateRandomXLightCache();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -0,0 +1,72 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veil/ringct/rctoutputcache.h>
+
+#include <test/test_veil.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(rctoutputcache_tests, BasicTestingSetup)
+
+static CAnonOutput MakeOutput(int64_t nIndex)
+{
+    COutPoint op(InsecureRand256(), (uint32_t)nIndex);
+    secp256k1_pedersen_commitment commitment;
+    memset(commitment.data, 0, sizeof(commitment.data));
+    return CAnonOutput(CCmpPubKey(), commitment, op, (int)nIndex, 0);
+}
+
+BOOST_AUTO_TEST_CASE(rctoutputcache_get_set_erase)
+{
+    veil::AnonOutputCache cache(64 * veil::AnonOutputCache::PAGE_SIZE * sizeof(CAnonOutput));
+
+    CAnonOutput ao;
+    BOOST_CHECK(!cache.Get(1, ao));
+
+    std::vector<CAnonOutput> vOutputs;
+    for (int64_t i = 0; i < 3000; i++) {
+        vOutputs.push_back(MakeOutput(i));
+        cache.Set(i, vOutputs.back());
+    }
+
+    for (int64_t i = 0; i < 3000; i++) {
+        BOOST_CHECK(cache.Get(i, ao));
+        BOOST_CHECK(ao.outpoint == vOutputs[i].outpoint);
+        BOOST_CHECK_EQUAL(ao.nBlockHeight, vOutputs[i].nBlockHeight);
+    }
+
+    // Erased entries must not be served, neighbours in the same page must be
+    cache.Erase(1500);
+    BOOST_CHECK(!cache.Get(1500, ao));
+    BOOST_CHECK(cache.Get(1499, ao));
+    BOOST_CHECK(cache.Get(1501, ao));
+
+    BOOST_CHECK(!cache.Get(-1, ao));
+    BOOST_CHECK(!cache.Get(3000, ao));
+
+    cache.Clear();
+    BOOST_CHECK(!cache.Get(0, ao));
+}
+
+BOOST_AUTO_TEST_CASE(rctoutputcache_eviction)
+{
+    // Room for two pages
+    veil::AnonOutputCache cache(2 * veil::AnonOutputCache::PAGE_SIZE * sizeof(CAnonOutput));
+    const int64_t nPage = veil::AnonOutputCache::PAGE_SIZE;
+
+    CAnonOutput ao;
+    cache.Set(0, MakeOutput(0));
+    cache.Set(nPage, MakeOutput(nPage));
+
+    // Touch the first page so the second one is the least recently used
+    BOOST_CHECK(cache.Get(0, ao));
+
+    cache.Set(2 * nPage, MakeOutput(2 * nPage));
+    BOOST_CHECK(cache.Get(0, ao));
+    BOOST_CHECK(!cache.Get(nPage, ao));
+    BOOST_CHECK(cache.Get(2 * nPage, ao));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,146 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txdb.h>
+
+#include <test/test_veil.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(rctviewcache_tests, BasicTestingSetup)
+
+static CAnonOutput MakeOutput(int64_t nIndex)
+{
+    COutPoint op(InsecureRand256(), (uint32_t)nIndex);
+    secp256k1_pedersen_commitment commitment;
+    memset(commitment.data, 0, sizeof(commitment.data));
+    return CAnonOutput(CCmpPubKey(), commitment, op, (int)nIndex, 0);
+}
+
+static CCmpPubKey MakeKey()
+{
+    std::vector<unsigned char> vch(33);
+    vch[0] = 2;
+    uint256 hash = InsecureRand256();
+    memcpy(&vch[1], hash.begin(), 32);
+    return CCmpPubKey(vch);
+}
+
+BOOST_AUTO_TEST_CASE(rctviewcache_read_through_and_erase)
+{
+    CBlockTreeDB db(1 << 20, true);
+    CRingCTViewCache view(&db);
+
+    CAnonOutput aoBase = MakeOutput(1);
+    CCmpPubKey pkBase = MakeKey(), kiBase = MakeKey();
+    uint256 txBase = InsecureRand256();
+    BOOST_CHECK(db.WriteRCTOutput(1, aoBase));
+    BOOST_CHECK(db.WriteRCTOutputLink(pkBase, 1));
+    BOOST_CHECK(db.WriteRCTKeyImage(kiBase, txBase));
+
+    // Entries that the view has no changes for are read from the base
+    CAnonOutput ao;
+    int64_t nIndex = 0;
+    uint256 txhash;
+    BOOST_CHECK(view.ReadRCTOutput(1, ao));
+    BOOST_CHECK(ao.outpoint == aoBase.outpoint);
+    BOOST_CHECK(view.ReadRCTOutputLink(pkBase, nIndex));
+    BOOST_CHECK_EQUAL(nIndex, 1);
+    BOOST_CHECK(view.ReadRCTKeyImage(kiBase, txhash));
+    BOOST_CHECK(txhash == txBase);
+    BOOST_CHECK(!view.ReadRCTOutput(2, ao));
+    BOOST_CHECK_EQUAL(view.GetCacheSize(), 0U);
+
+    // A pending erase hides the base entry, but doesn't touch the base until flushed
+    BOOST_CHECK(view.EraseRCTOutput(1));
+    BOOST_CHECK(view.EraseRCTOutputLink(pkBase));
+    BOOST_CHECK(view.EraseRCTKeyImage(kiBase));
+    BOOST_CHECK(!view.ReadRCTOutput(1, ao));
+    BOOST_CHECK(!view.ReadRCTOutputLink(pkBase, nIndex));
+    BOOST_CHECK(!view.ReadRCTKeyImage(kiBase, txhash));
+    BOOST_CHECK(db.ReadRCTOutput(1, ao));
+    BOOST_CHECK(db.ReadRCTOutputLink(pkBase, nIndex));
+    BOOST_CHECK(db.ReadRCTKeyImage(kiBase, txhash));
+    BOOST_CHECK_EQUAL(view.GetCacheSize(), 3U);
+
+    // Writing after an erase replaces the pending erase
+    CAnonOutput aoNew = MakeOutput(1);
+    uint256 txNew = InsecureRand256();
+    BOOST_CHECK(view.WriteRCTOutput(1, aoNew));
+    BOOST_CHECK(view.WriteRCTOutputLink(pkBase, 5));
+    BOOST_CHECK(view.WriteRCTKeyImage(kiBase, txNew));
+    BOOST_CHECK(view.ReadRCTOutput(1, ao));
+    BOOST_CHECK(ao.outpoint == aoNew.outpoint);
+    BOOST_CHECK(view.ReadRCTOutputLink(pkBase, nIndex));
+    BOOST_CHECK_EQUAL(nIndex, 5);
+    BOOST_CHECK(view.ReadRCTKeyImage(kiBase, txhash));
+    BOOST_CHECK(txhash == txNew);
+    BOOST_CHECK_EQUAL(view.GetCacheSize(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(rctviewcache_flush)
+{
+    CBlockTreeDB db(1 << 20, true);
+    CRingCTViewCache view(&db);
+    size_t nEmptyUsage = view.DynamicMemoryUsage();
+
+    CAnonOutput aoErased = MakeOutput(1);
+    CCmpPubKey pkErased = MakeKey(), kiErased = MakeKey();
+    BOOST_CHECK(db.WriteRCTOutput(1, aoErased));
+    BOOST_CHECK(db.WriteRCTOutputLink(pkErased, 1));
+    BOOST_CHECK(db.WriteRCTKeyImage(kiErased, InsecureRand256()));
+
+    std::vector<CAnonOutput> vOutputs;
+    std::vector<CCmpPubKey> vKeys, vKeyImages;
+    std::vector<uint256> vTxHashes;
+    for (int64_t i = 2; i < 12; i++) {
+        vOutputs.push_back(MakeOutput(i));
+        vKeys.push_back(MakeKey());
+        vKeyImages.push_back(MakeKey());
+        vTxHashes.push_back(InsecureRand256());
+        BOOST_CHECK(view.WriteRCTOutput(i, vOutputs.back()));
+        BOOST_CHECK(view.WriteRCTOutputLink(vKeys.back(), i));
+        BOOST_CHECK(view.WriteRCTKeyImage(vKeyImages.back(), vTxHashes.back()));
+    }
+    BOOST_CHECK(view.EraseRCTOutput(1));
+    BOOST_CHECK(view.EraseRCTOutputLink(pkErased));
+    BOOST_CHECK(view.EraseRCTKeyImage(kiErased));
+
+    BOOST_CHECK_EQUAL(view.GetCacheSize(), 33U);
+    BOOST_CHECK(view.DynamicMemoryUsage() > nEmptyUsage);
+
+    // Nothing reaches the base before the flush
+    CAnonOutput ao;
+    int64_t nIndex = 0;
+    uint256 txhash;
+    BOOST_CHECK(!db.ReadRCTOutput(2, ao));
+    BOOST_CHECK(!db.ReadRCTOutputLink(vKeys[0], nIndex));
+    BOOST_CHECK(!db.ReadRCTKeyImage(vKeyImages[0], txhash));
+
+    BOOST_CHECK(view.Flush());
+    BOOST_CHECK_EQUAL(view.GetCacheSize(), 0U);
+    BOOST_CHECK_EQUAL(view.DynamicMemoryUsage(), nEmptyUsage);
+
+    // The writes and erases are in the base now, and still read the same through the view
+    for (size_t i = 0; i < vOutputs.size(); i++) {
+        BOOST_CHECK(db.ReadRCTOutput(i + 2, ao));
+        BOOST_CHECK(ao.outpoint == vOutputs[i].outpoint);
+        BOOST_CHECK(db.ReadRCTOutputLink(vKeys[i], nIndex));
+        BOOST_CHECK_EQUAL(nIndex, (int64_t)i + 2);
+        BOOST_CHECK(db.ReadRCTKeyImage(vKeyImages[i], txhash));
+        BOOST_CHECK(txhash == vTxHashes[i]);
+        BOOST_CHECK(view.ReadRCTOutput(i + 2, ao));
+        BOOST_CHECK(ao.outpoint == vOutputs[i].outpoint);
+    }
+    BOOST_CHECK(!db.ReadRCTOutput(1, ao));
+    BOOST_CHECK(!db.ReadRCTOutputLink(pkErased, nIndex));
+    BOOST_CHECK(!db.ReadRCTKeyImage(kiErased, txhash));
+    BOOST_CHECK(!view.ReadRCTOutput(1, ao));
+
+    // Flushing without changes is a no-op
+    BOOST_CHECK(view.Flush());
+    BOOST_CHECK_EQUAL(view.GetCacheSize(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,158 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veil/ringct/stealthscan.h>
+
+#include <test/test_veil.h>
+
+#include <boost/test/unit_test.hpp>
+
+struct StealthScanTestingSetup : public BasicTestingSetup
+{
+    StealthScanTestingSetup() { ECC_Start_Stealth(); }
+    ~StealthScanTestingSetup() { ECC_Stop_Stealth(); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(stealthscan_tests, StealthScanTestingSetup)
+
+static CStealthScanKey MakeScanKey(uint8_t nPrefixBits = 0, uint32_t nPrefix = 0)
+{
+    CStealthScanKey key;
+    key.scan_secret.MakeNewKey(true);
+    SecretToPublicKey(key.scan_secret, key.scan_pubkey);
+    CKey spend_secret;
+    spend_secret.MakeNewKey(true);
+    SecretToPublicKey(spend_secret, key.spend_pubkey);
+    key.idAddress = key.scan_secret.GetPubKey().GetID();
+    key.prefix.number_bits = nPrefixBits;
+    key.prefix.bitfield = nPrefix;
+    return key;
+}
+
+// Build an output the way a sender would, from the public keys of the address
+static CStealthScanOutput MakeOutput(const CStealthScanKey &key, uint32_t nPrefix = 0, bool fHavePrefix = false)
+{
+    CStealthScanOutput out;
+    CKey sEphem, sShared;
+    ec_point pkSendTo;
+    do {
+        sEphem.MakeNewKey(true);
+    } while (StealthSecret(sEphem, key.scan_pubkey, key.spend_pubkey, sShared, pkSendTo) != 0);
+
+    SecretToPublicKey(sEphem, out.vchEphemPK);
+    out.idDestination = CPubKey(pkSendTo).GetID();
+    out.prefix = nPrefix;
+    out.fHavePrefix = fHavePrefix;
+    return out;
+}
+
+BOOST_AUTO_TEST_CASE(stealthscan_matches)
+{
+    std::vector<CStealthScanKey> vKeys;
+    vKeys.push_back(MakeScanKey());
+    vKeys.push_back(MakeScanKey());
+    vKeys.push_back(MakeScanKey(8, 0xa5));
+
+    std::vector<CStealthScanOutput> vOutputs;
+    std::vector<int> vExpected;
+    for (int i = 0; i < 20; i++) {
+        // Sent to an address that isn't scanned
+        vOutputs.push_back(MakeOutput(MakeScanKey()));
+        vExpected.push_back(-1);
+    }
+    vOutputs.push_back(MakeOutput(vKeys[1]));
+    vExpected.push_back(1);
+    vOutputs.push_back(MakeOutput(vKeys[0]));
+    vExpected.push_back(0);
+    vOutputs.push_back(MakeOutput(vKeys[2], 0x12a5, true));
+    vExpected.push_back(2);
+    // The prefix of the output doesn't match the address, so it is not checked
+    vOutputs.push_back(MakeOutput(vKeys[2], 0x12a6, true));
+    vExpected.push_back(-1);
+    vOutputs.push_back(MakeOutput(vKeys[2]));
+    vExpected.push_back(-1);
+
+    for (int nThreads : {1, 2, 4}) {
+        std::vector<int> vMatches;
+        ScanStealthOutputs(vKeys, vOutputs, vMatches, nThreads);
+        BOOST_CHECK(vMatches == vExpected);
+    }
+
+    std::vector<int> vMatches;
+    ScanStealthOutputs(std::vector<CStealthScanKey>(), vOutputs, vMatches, 4);
+    BOOST_CHECK(vMatches == std::vector<int>(vOutputs.size(), -1));
+}
+
+// Another spend key under the scan secret of key
+static CStealthScanKey MakeSharedScanKey(const CStealthScanKey &key, uint8_t nPrefixBits = 0, uint32_t nPrefix = 0)
+{
+    CStealthScanKey shared = MakeScanKey(nPrefixBits, nPrefix);
+    shared.scan_secret = key.scan_secret;
+    shared.scan_pubkey = key.scan_pubkey;
+    return shared;
+}
+
+BOOST_AUTO_TEST_CASE(stealthscan_shared_scan_secret)
+{
+    std::vector<CStealthScanKey> vKeys;
+    vKeys.push_back(MakeScanKey());
+    vKeys.push_back(MakeSharedScanKey(vKeys[0]));
+    vKeys.push_back(MakeScanKey());
+    vKeys.push_back(MakeSharedScanKey(vKeys[0], 8, 0xa5));
+    vKeys.push_back(MakeSharedScanKey(vKeys[0], 4, 0x3));
+    vKeys.push_back(MakeSharedScanKey(vKeys[2]));
+
+    std::vector<CStealthScanOutput> vOutputs;
+    for (int i = 0; i < 10; i++)
+        vOutputs.push_back(MakeOutput(MakeScanKey()));
+    // Sent to a key of the group, but not with the group's other keys
+    vOutputs.push_back(MakeOutput(MakeSharedScanKey(vKeys[0])));
+    for (size_t i = 0; i < vKeys.size(); i++)
+        vOutputs.push_back(MakeOutput(vKeys[i]));
+    vOutputs.push_back(MakeOutput(vKeys[3], 0x12a5, true));
+    vOutputs.push_back(MakeOutput(vKeys[3], 0x12a6, true));
+    vOutputs.push_back(MakeOutput(vKeys[4], 0x13, true));
+    vOutputs.push_back(MakeOutput(vKeys[1], 0x13, true));
+
+    // Every (output, key) pair with a matching prefix through StealthSecret
+    std::vector<int> vExpected(vOutputs.size(), -1);
+    for (size_t o = 0; o < vOutputs.size(); o++) {
+        const CStealthScanOutput &out = vOutputs[o];
+        for (size_t k = 0; k < vKeys.size(); k++) {
+            const CStealthScanKey &key = vKeys[k];
+            if (!MatchPrefix(key.prefix.number_bits, key.prefix.bitfield, out.prefix, out.fHavePrefix))
+                continue;
+            CKey sShared;
+            ec_point pkExtracted;
+            if (StealthSecret(key.scan_secret, out.vchEphemPK, key.spend_pubkey, sShared, pkExtracted) == 0
+                && CPubKey(pkExtracted).GetID() == out.idDestination) {
+                vExpected[o] = k;
+            }
+        }
+    }
+    // Keys with a prefix only see the outputs that carry it
+    BOOST_CHECK_EQUAL(vExpected[10], -1);
+    BOOST_CHECK_EQUAL(vExpected[11], 0);
+    BOOST_CHECK_EQUAL(vExpected[14], -1);
+    BOOST_CHECK_EQUAL(vExpected[15], -1);
+    BOOST_CHECK_EQUAL(vExpected[17], 3);
+    BOOST_CHECK_EQUAL(vExpected[18], -1);
+    BOOST_CHECK_EQUAL(vExpected[19], 4);
+    BOOST_CHECK_EQUAL(vExpected[20], 1);
+
+    for (int nThreads : {1, 2, 4}) {
+        std::vector<int> vMatches;
+        ScanStealthOutputs(vKeys, vOutputs, vMatches, nThreads);
+        BOOST_CHECK(vMatches == vExpected);
+    }
+
+    // Without scan pubkeys every key is scanned on its own, with the same result
+    for (CStealthScanKey &key : vKeys)
+        key.scan_pubkey.clear();
+    std::vector<int> vMatches;
+    ScanStealthOutputs(vKeys, vOutputs, vMatches, 2);
+    BOOST_CHECK(vMatches == vExpected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
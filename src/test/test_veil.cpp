@@ -17,6 +17,7 @@
 #include <rpc/server.h>
 #include <rpc/register.h>
 #include <script/sigcache.h>
+#include <veil/workerpool.h>
 
 void CConnmanTest::AddNode(CNode& node)
 {
@@ -90,6 +91,7 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
 
         mempool.setSanityCheck(1.0);
         pblocktree.reset(new CBlockTreeDB(1 << 20, true));
+        prctviewTip.reset(new CRingCTViewCache(pblocktree.get()));
         pcoinsdbview.reset(new CCoinsViewDB(1 << 23, true));
         pcoinsTip.reset(new CCoinsViewCache(pcoinsdbview.get()));
         if (!LoadGenesisBlock(chainparams)) {
@@ -102,8 +104,12 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
             }
         }
         nScriptCheckThreads = 3;
-        for (int i=0; i < nScriptCheckThreads-1; i++)
+        for (int i=0; i < nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+            threadGroup.create_thread(&ThreadMLSAGCheck);
+            threadGroup.create_thread(&ThreadRangeProofCheck);
+            threadGroup.create_thread(&veil::ThreadWorkerPool);
+        }
         g_connman = std::unique_ptr<CConnman>(new CConnman(0x1337, 0x1337)); // Deterministic randomness for tests.
         connman = g_connman.get();
         peerLogic.reset(new PeerLogicValidation(connman, scheduler, /*enable_bip61=*/true));
@@ -120,6 +126,7 @@ TestingSetup::~TestingSetup()
         UnloadBlockIndex();
         pcoinsTip.reset();
         pcoinsdbview.reset();
+        prctviewTip.reset();
         pblocktree.reset();
 }
 
@@ -16,12 +16,13 @@
 #include <core_io.h>
 #include <keystore.h>
 #include <policy/policy.h>
+#include <veil/ringct/anon.h>
 #include <veil/ringct/stealth.h>
 #include <veil/ringct/extkey.h>
 
 #include <boost/test/unit_test.hpp>
 
-bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks, bool fAnonChecks = true);
+bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks, bool fAnonChecks = true, std::vector<CMLSAGCheck> *pvMLSAGChecks = nullptr);
 
 BOOST_AUTO_TEST_SUITE(tx_validationcache_tests)
 
@@ -0,0 +1,73 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veil/workerpool.h>
+
+#include <test/test_veil.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(workerpool_tests, BasicTestingSetup)
+
+static void CheckRunsAllTasks(veil::WorkerPool& pool)
+{
+    for (size_t nTasks : {0, 1, 2, 3, 100}) {
+        std::vector<std::atomic<int>> vCalls(nTasks);
+        for (auto& nCalls : vCalls)
+            nCalls = 0;
+        pool.Run(nTasks, [&vCalls](size_t nTask) { vCalls[nTask]++; });
+        for (const auto& nCalls : vCalls)
+            BOOST_CHECK_EQUAL(nCalls.load(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(workerpool_without_workers)
+{
+    // Without workers, all tasks run on the calling thread
+    veil::WorkerPool pool;
+    BOOST_CHECK_EQUAL(pool.GetWorkerCount(), 0);
+    CheckRunsAllTasks(pool);
+}
+
+BOOST_AUTO_TEST_CASE(workerpool_with_workers)
+{
+    veil::WorkerPool pool;
+    boost::thread_group threadGroup;
+    for (int i = 0; i < 3; i++)
+        threadGroup.create_thread([&pool] { pool.Thread(); });
+
+    CheckRunsAllTasks(pool);
+
+    // Tasks can run tasks of their own, while other threads use the pool as well
+    std::atomic<int> nCalls(0);
+    auto run = [&pool, &nCalls] {
+        pool.Run(10, [&pool, &nCalls](size_t) { pool.Run(10, [&nCalls](size_t) { nCalls++; }); });
+    };
+    boost::thread_group callers;
+    for (int i = 0; i < 3; i++)
+        callers.create_thread(run);
+    run();
+    callers.join_all();
+    BOOST_CHECK_EQUAL(nCalls.load(), 400);
+
+    // An exception thrown by a task is rethrown to the caller once the other tasks are done
+    nCalls = 0;
+    BOOST_CHECK_THROW(pool.Run(20, [&nCalls](size_t nTask) {
+        nCalls++;
+        if (nTask == 5)
+            throw std::runtime_error("task failed");
+    }), std::runtime_error);
+    BOOST_CHECK_EQUAL(nCalls.load(), 20);
+
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+    BOOST_CHECK_EQUAL(pool.GetWorkerCount(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
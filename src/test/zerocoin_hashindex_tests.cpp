@@ -0,0 +1,62 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veil/zerocoin/zhashindex.h>
+
+#include <test/test_veil.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(zerocoin_hashindex_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(zerocoin_hashindex_unloaded)
+{
+    veil::ZerocoinHashIndex index;
+
+    // Until loaded, every hash has to be looked up in the db
+    BOOST_CHECK(!index.IsLoaded());
+    BOOST_CHECK(index.MaybeContains(InsecureRand256()));
+    index.Add(InsecureRand256());
+    BOOST_CHECK_EQUAL(index.Size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(zerocoin_hashindex_add_lookup)
+{
+    std::vector<uint256> vLoaded;
+    std::vector<uint64_t> vKeys;
+    for (int i = 0; i < 500; i++) {
+        vLoaded.emplace_back(InsecureRand256());
+        vKeys.emplace_back(vLoaded.back().GetUint64(0));
+    }
+
+    veil::ZerocoinHashIndex index;
+    index.Load(std::move(vKeys));
+    BOOST_CHECK(index.IsLoaded());
+
+    // Enough additions to go through several merges, and leave some in the recent buffer
+    std::vector<uint256> vAdded;
+    for (size_t i = 0; i < 3 * veil::ZerocoinHashIndex::MERGE_SIZE + 10; i++) {
+        vAdded.emplace_back(InsecureRand256());
+        index.Add(vAdded.back());
+    }
+    BOOST_CHECK_EQUAL(index.Size(), vLoaded.size() + vAdded.size());
+
+    for (const uint256& hash : vLoaded)
+        BOOST_CHECK(index.MaybeContains(hash));
+    for (const uint256& hash : vAdded)
+        BOOST_CHECK(index.MaybeContains(hash));
+
+    int nFalsePositives = 0;
+    for (int i = 0; i < 1000; i++) {
+        if (index.MaybeContains(InsecureRand256()))
+            nFalsePositives++;
+    }
+    BOOST_CHECK_EQUAL(nFalsePositives, 0);
+
+    index.Unload();
+    BOOST_CHECK(!index.IsLoaded());
+    BOOST_CHECK(index.MaybeContains(InsecureRand256()));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
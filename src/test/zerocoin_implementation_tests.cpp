@@ -641,4 +641,94 @@ BOOST_AUTO_TEST_CASE(test_coinspendv4)
 
 
 
+BOOST_AUTO_TEST_CASE(batched_accumulation)
+{
+    cout << "Running batched_accumulation...\n";
+
+    std::vector<libzerocoin::PublicCoin> vPubcoins;
+    std::vector<CBigNum> vValues;
+    for (unsigned int i = 0; i < 10; i++) {
+        PrivateCoin c(Params().Zerocoin_Params(), i % 2 ? CoinDenomination::ZQ_TEN : CoinDenomination::ZQ_ONE_HUNDRED, true);
+        vPubcoins.emplace_back(c.getPublicCoin());
+        if (i % 2)
+            vValues.emplace_back(c.getPublicCoin().getValue());
+    }
+
+    //the serial result
+    Accumulator accumulator(Params().Zerocoin_Params(), CoinDenomination::ZQ_TEN);
+    for (const CBigNum& bnValue : vValues)
+        accumulator.increment(bnValue);
+
+    //batches smaller than, equal to and larger than the number of values
+    for (size_t nBatchSize : {(size_t)1, (size_t)2, (size_t)3, vValues.size(), (size_t)ACCUMULATOR_BATCH_SIZE}) {
+        Accumulator accumulatorBatched(Params().Zerocoin_Params(), CoinDenomination::ZQ_TEN);
+        accumulatorBatched.increment(vValues, nBatchSize);
+        BOOST_CHECK_MESSAGE(accumulatorBatched.getValue() == accumulator.getValue(), strprintf("batch size %d", nBatchSize));
+    }
+
+    //the accumulator map splits the batch by denomination
+    AccumulatorMap mapSerial(Params().Zerocoin_Params());
+    for (const auto& pubcoin : vPubcoins)
+        BOOST_CHECK(mapSerial.Accumulate(pubcoin));
+    AccumulatorMap mapBatched(Params().Zerocoin_Params());
+    BOOST_CHECK(mapBatched.Accumulate(vPubcoins));
+    BOOST_CHECK(mapBatched.GetCheckpoints() == mapSerial.GetCheckpoints());
+    BOOST_CHECK(mapBatched.GetValue(CoinDenomination::ZQ_TEN) == accumulator.getValue());
+}
+
+BOOST_AUTO_TEST_CASE(fixed_base_tables)
+{
+    cout << "Running fixed_base_tables...\n";
+
+    const ZerocoinParams* params = Params().Zerocoin_Params();
+    for (const IntegerGroupParams* group : {&params->coinCommitmentGroup, &params->serialNumberSoKCommitmentGroup,
+                                            &params->accumulatorParams.accumulatorPoKCommitmentGroup}) {
+        //exponents inside and outside of [0, groupOrder)
+        std::vector<CBigNum> vExponents = {CBigNum(0), CBigNum(1), group->groupOrder, group->groupOrder - 1, CBigNum(-5)};
+        for (int i = 0; i < 5; i++) {
+            vExponents.emplace_back(CBigNum::randBignum(group->groupOrder));
+            vExponents.emplace_back(CBigNum::randBignum(group->groupOrder * 3) * -1);
+        }
+
+        for (const CBigNum& e : vExponents) {
+            BOOST_CHECK(group->pow_g(e) == group->g.pow_mod(e, group->modulus));
+            BOOST_CHECK(group->pow_h(e) == group->h.pow_mod(e, group->modulus));
+        }
+    }
+
+    const IntegerGroupParams& group = params->serialNumberSoKCommitmentGroup;
+    CBigNum e = CBigNum::randBignum(group.groupOrder);
+    BOOST_CHECK(group.pow_u_inner(e) == group.u_inner_prod.pow_mod(e, group.modulus));
+}
+
+BOOST_AUTO_TEST_CASE(block_has_zerocoins)
+{
+    cout << "Running block_has_zerocoins...\n";
+
+    CBlockIndex indexPrev;
+    indexPrev.nHeight = Params().HeightLightZerocoin() + 10;
+    indexPrev.mapZerocoinSupply.at(CoinDenomination::ZQ_TEN) = 5;
+
+    CBlockIndex index;
+    index.pprev = &indexPrev;
+    index.nHeight = indexPrev.nHeight + 1;
+    index.mapZerocoinSupply = indexPrev.mapZerocoinSupply;
+    BOOST_CHECK(!BlockHasZerocoins(&index));
+
+    // A mint, even if a spend of the same denomination leaves the supply unchanged
+    index.vMintDenominationsInBlock.emplace_back(CoinDenomination::ZQ_TEN);
+    BOOST_CHECK(BlockHasZerocoins(&index));
+
+    // A spend without mints
+    index.vMintDenominationsInBlock.clear();
+    index.mapZerocoinSupply.at(CoinDenomination::ZQ_TEN) = 4;
+    BOOST_CHECK(BlockHasZerocoins(&index));
+
+    // The genesis block and the light zerocoin fork are always read
+    index.mapZerocoinSupply = indexPrev.mapZerocoinSupply;
+    index.nHeight = Params().HeightLightZerocoin();
+    BOOST_CHECK(BlockHasZerocoins(&index));
+    BOOST_CHECK(BlockHasZerocoins(&indexPrev));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
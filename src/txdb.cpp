@@ -158,7 +158,8 @@ size_t CCoinsViewDB::EstimateSize() const
     return db.EstimateSize(DB_COIN, (char)(DB_COIN+1));
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(gArgs.IsArgSet("-blocksdir") ? GetDataDir() / "blocks" / "index" : GetBlocksDir() / "index", nCacheSize, fMemory, fWipe) {
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(gArgs.IsArgSet("-blocksdir") ? GetDataDir() / "blocks" / "index" : GetBlocksDir() / "index", nCacheSize, fMemory, fWipe),
+    cacheRCTOutputs(std::max((int64_t)0, gArgs.GetArg("-rctoutputcache", DEFAULT_RCT_OUTPUT_CACHE)) << 20) {
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -315,6 +316,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
                 pindexNew->nMoneySupply = diskindex.nMoneySupply;
                 pindexNew->fProofOfStake = diskindex.fProofOfStake;
                 pindexNew->vHashProof = diskindex.vHashProof;
+                pindexNew->hashModifierPoW = diskindex.hashModifierPoW;
 
                 //PoFN
                 pindexNew->fProofOfFullNode = diskindex.fProofOfFullNode;
@@ -348,23 +350,46 @@ bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams,
 
 bool CBlockTreeDB::ReadRCTOutput(int64_t i, CAnonOutput &ao)
 {
-    return Read(std::make_pair(DB_RCTOUTPUT, i), ao);
+    if (cacheRCTOutputs.Get(i, ao))
+        return true;
+
+    if (!Read(std::make_pair(DB_RCTOUTPUT, i), ao))
+        return false;
+
+    cacheRCTOutputs.Set(i, ao);
+    return true;
 };
 
 bool CBlockTreeDB::WriteRCTOutput(int64_t i, const CAnonOutput &ao)
 {
     CDBBatch batch(*this);
     batch.Write(std::make_pair(DB_RCTOUTPUT, i), ao);
-    return WriteBatch(batch);
+    if (!WriteBatch(batch))
+        return false;
+
+    cacheRCTOutputs.Set(i, ao);
+    return true;
 };
 
 bool CBlockTreeDB::EraseRCTOutput(int64_t i)
 {
+    cacheRCTOutputs.Erase(i);
+
     CDBBatch batch(*this);
     batch.Erase(std::make_pair(DB_RCTOUTPUT, i));
     return WriteBatch(batch);
 };
 
+void CBlockTreeDB::CacheRCTOutput(int64_t i, const CAnonOutput &ao)
+{
+    cacheRCTOutputs.Set(i, ao);
+}
+
+void CBlockTreeDB::UncacheRCTOutput(int64_t i)
+{
+    cacheRCTOutputs.Erase(i);
+}
+
 
 bool CBlockTreeDB::ReadRCTOutputLink(const CCmpPubKey &pk, int64_t &i)
 {
@@ -404,6 +429,149 @@ bool CBlockTreeDB::EraseRCTKeyImage(const CCmpPubKey &ki)
     return WriteBatch(batch);
 };
 
+bool CRingCTViewCache::ReadRCTOutput(int64_t i, CAnonOutput &ao)
+{
+    {
+        LOCK(cs_rctview);
+        auto it = mapOutputs.find(i);
+        if (it != mapOutputs.end()) {
+            if (it->second.fErased)
+                return false;
+            ao = it->second.value;
+            return true;
+        }
+    }
+    return base->ReadRCTOutput(i, ao);
+}
+
+bool CRingCTViewCache::WriteRCTOutput(int64_t i, const CAnonOutput &ao)
+{
+    LOCK(cs_rctview);
+    mapOutputs[i] = CacheEntry<CAnonOutput>(ao, false);
+    return true;
+}
+
+bool CRingCTViewCache::EraseRCTOutput(int64_t i)
+{
+    LOCK(cs_rctview);
+    mapOutputs[i] = CacheEntry<CAnonOutput>(CAnonOutput(), true);
+    return true;
+}
+
+bool CRingCTViewCache::ReadRCTOutputLink(const CCmpPubKey &pk, int64_t &i)
+{
+    {
+        LOCK(cs_rctview);
+        auto it = mapOutputLinks.find(pk);
+        if (it != mapOutputLinks.end()) {
+            if (it->second.fErased)
+                return false;
+            i = it->second.value;
+            return true;
+        }
+    }
+    return base->ReadRCTOutputLink(pk, i);
+}
+
+bool CRingCTViewCache::WriteRCTOutputLink(const CCmpPubKey &pk, int64_t i)
+{
+    LOCK(cs_rctview);
+    mapOutputLinks[pk] = CacheEntry<int64_t>(i, false);
+    return true;
+}
+
+bool CRingCTViewCache::EraseRCTOutputLink(const CCmpPubKey &pk)
+{
+    LOCK(cs_rctview);
+    mapOutputLinks[pk] = CacheEntry<int64_t>(0, true);
+    return true;
+}
+
+bool CRingCTViewCache::ReadRCTKeyImage(const CCmpPubKey &ki, uint256 &txhash)
+{
+    {
+        LOCK(cs_rctview);
+        auto it = mapKeyImages.find(ki);
+        if (it != mapKeyImages.end()) {
+            if (it->second.fErased)
+                return false;
+            txhash = it->second.value;
+            return true;
+        }
+    }
+    return base->ReadRCTKeyImage(ki, txhash);
+}
+
+bool CRingCTViewCache::WriteRCTKeyImage(const CCmpPubKey &ki, const uint256 &txhash)
+{
+    LOCK(cs_rctview);
+    mapKeyImages[ki] = CacheEntry<uint256>(txhash, false);
+    return true;
+}
+
+bool CRingCTViewCache::EraseRCTKeyImage(const CCmpPubKey &ki)
+{
+    LOCK(cs_rctview);
+    mapKeyImages[ki] = CacheEntry<uint256>(uint256(), true);
+    return true;
+}
+
+bool CRingCTViewCache::Flush()
+{
+    LOCK(cs_rctview);
+    if (mapOutputs.empty() && mapOutputLinks.empty() && mapKeyImages.empty())
+        return true;
+
+    CDBBatch batch(*base);
+    for (const auto &it : mapKeyImages) {
+        if (it.second.fErased)
+            batch.Erase(std::make_pair(DB_RCTKEYIMAGE, it.first));
+        else
+            batch.Write(std::make_pair(DB_RCTKEYIMAGE, it.first), it.second.value);
+    }
+    for (const auto &it : mapOutputs) {
+        if (it.second.fErased)
+            batch.Erase(std::make_pair(DB_RCTOUTPUT, it.first));
+        else
+            batch.Write(std::make_pair(DB_RCTOUTPUT, it.first), it.second.value);
+    }
+    for (const auto &it : mapOutputLinks) {
+        if (it.second.fErased)
+            batch.Erase(std::make_pair(DB_RCTOUTPUT_LINK, it.first));
+        else
+            batch.Write(std::make_pair(DB_RCTOUTPUT_LINK, it.first), it.second.value);
+    }
+
+    LogPrint(BCLog::COINDB, "Writing RingCT index: %u outputs, %u links, %u key images\n",
+            mapOutputs.size(), mapOutputLinks.size(), mapKeyImages.size());
+    if (!base->WriteBatch(batch, true))
+        return false;
+
+    for (const auto &it : mapOutputs) {
+        if (it.second.fErased)
+            base->UncacheRCTOutput(it.first);
+        else
+            base->CacheRCTOutput(it.first, it.second.value);
+    }
+
+    mapOutputs.clear();
+    mapOutputLinks.clear();
+    mapKeyImages.clear();
+    return true;
+}
+
+size_t CRingCTViewCache::GetCacheSize() const
+{
+    LOCK(cs_rctview);
+    return mapOutputs.size() + mapOutputLinks.size() + mapKeyImages.size();
+}
+
+size_t CRingCTViewCache::DynamicMemoryUsage() const
+{
+    LOCK(cs_rctview);
+    return memusage::DynamicUsage(mapOutputs) + memusage::DynamicUsage(mapOutputLinks) + memusage::DynamicUsage(mapKeyImages);
+}
+
 namespace {
 
 //! Legacy class to deserialize pre-pertxout database entries without reindex.
@@ -539,6 +707,7 @@ bool CZerocoinDB::WriteCoinMintBatch(const std::map<libzerocoin::PublicCoin, uin
     for (auto it=mintInfo.begin(); it != mintInfo.end(); it++) {
         libzerocoin::PublicCoin pubCoin = it->first;
         uint256 hash = GetPubCoinHash(pubCoin.getValue());
+        indexPubcoins.Add(hash);
         batch.Write(std::make_pair('m', hash), it->second);
         ++count;
     }
@@ -554,6 +723,8 @@ bool CZerocoinDB::ReadCoinMint(const CBigNum& bnPubcoin, uint256& hashTx)
 
 bool CZerocoinDB::ReadCoinMint(const uint256& hashPubcoin, uint256& hashTx)
 {
+    if (!indexPubcoins.MaybeContains(hashPubcoin))
+        return false;
     return Read(std::make_pair('m', hashPubcoin), hashTx);
 }
 
@@ -572,6 +743,7 @@ bool CZerocoinDB::WriteCoinSpendBatch(const std::map<libzerocoin::CoinSpend, uin
         CDataStream ss(SER_GETHASH, 0);
         ss << bnSerial;
         uint256 hash = Hash(ss.begin(), ss.end());
+        indexSerials.Add(hash);
         batch.Write(std::make_pair('s', hash), it->second);
         ++count;
     }
@@ -586,11 +758,13 @@ bool CZerocoinDB::ReadCoinSpend(const CBigNum& bnSerial, uint256& txHash)
     ss << bnSerial;
     uint256 hash = Hash(ss.begin(), ss.end());
 
-    return Read(std::make_pair('s', hash), txHash);
+    return ReadCoinSpend(hash, txHash);
 }
 
 bool CZerocoinDB::ReadCoinSpend(const uint256& hashSerial, uint256 &txHash)
 {
+    if (!indexSerials.MaybeContains(hashSerial))
+        return false;
     return Read(std::make_pair('s', hashSerial), txHash);
 }
 
@@ -669,6 +843,29 @@ bool CZerocoinDB::WipeCoins(std::string strType)
     return true;
 }
 
+bool CZerocoinDB::LoadHashIndex()
+{
+    for (char type : {'m', 's'}) {
+        std::vector<uint64_t> vHashes;
+        std::unique_ptr<CDBIterator> pcursor(NewIterator());
+        pcursor->Seek(std::make_pair(type, uint256()));
+        while (pcursor->Valid()) {
+            boost::this_thread::interruption_point();
+            std::pair<char, uint256> key;
+            if (!pcursor->GetKey(key) || key.first != type)
+                break;
+            vHashes.emplace_back(key.second.GetUint64(0));
+            pcursor->Next();
+        }
+
+        veil::ZerocoinHashIndex& index = (type == 'm' ? indexPubcoins : indexSerials);
+        index.Load(std::move(vHashes));
+    }
+
+    LogPrintf("%s: loaded %u pubcoin and %u serial hashes\n", __func__, indexPubcoins.Size(), indexSerials.Size());
+    return true;
+}
+
 bool CZerocoinDB::WriteAccumulatorValue(const uint256& hashChecksum, const CBigNum& bnValue)
 {
     LogPrint(BCLog::ZEROCOINDB,"%s : checksum:%d val:%s\n", __func__, hashChecksum.GetHex(), bnValue.GetHex());
@@ -686,6 +883,35 @@ bool CZerocoinDB::EraseAccumulatorValue(const uint256& hashChecksum)
     return Erase(std::make_pair('2', hashChecksum));
 }
 
+bool CZerocoinDB::WriteBlockPubcoinBatch(int nHeight, const uint256& hashBlock, const std::map<libzerocoin::CoinDenomination, std::vector<CBigNum> >& mapPubcoins)
+{
+    CDBBatch batch(*this);
+    for (const auto& denomPair : mapPubcoins)
+        batch.Write(std::make_pair('d', std::make_pair(nHeight, (int)denomPair.first)), std::make_pair(hashBlock, denomPair.second));
+
+    LogPrint(BCLog::ZEROCOINDB, "Writing pubcoins of %u denominations at height %d to db.\n", (unsigned int)mapPubcoins.size(), nHeight);
+    return WriteBatch(batch);
+}
+
+bool CZerocoinDB::ReadBlockPubcoins(int nHeight, libzerocoin::CoinDenomination denom, const uint256& hashBlock, std::vector<CBigNum>& vPubcoins)
+{
+    std::pair<uint256, std::vector<CBigNum> > pairPubcoins;
+    if (!Read(std::make_pair('d', std::make_pair(nHeight, (int)denom)), pairPubcoins))
+        return false;
+
+    // An entry left behind by a block that is no longer in the chain
+    if (pairPubcoins.first != hashBlock)
+        return false;
+
+    vPubcoins = std::move(pairPubcoins.second);
+    return true;
+}
+
+bool CZerocoinDB::EraseBlockPubcoins(int nHeight, libzerocoin::CoinDenomination denom)
+{
+    return Erase(std::make_pair('d', std::make_pair(nHeight, (int)denom)));
+}
+
 bool CZerocoinDB::LoadBlacklistOutPoints()
 {
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
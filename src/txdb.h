@@ -10,6 +10,8 @@
 #include <dbwrapper.h>
 #include <chain.h>
 #include <veil/ringct/rctindex.h>
+#include <veil/ringct/rctoutputcache.h>
+#include <veil/zerocoin/zhashindex.h>
 #include <primitives/block.h>
 #include <libzerocoin/Coin.h>
 #include <libzerocoin/CoinSpend.h>
@@ -92,6 +94,10 @@ private:
 /** Access to the block database (blocks/index/) */
 class CBlockTreeDB : public CDBWrapper
 {
+private:
+    //! In-memory copy of recently used DB_RCTOUTPUT entries, sized by -rctoutputcache
+    veil::AnonOutputCache cacheRCTOutputs;
+
 public:
     explicit CBlockTreeDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
@@ -104,6 +110,49 @@ public:
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
 
+    bool ReadRCTOutput(int64_t i, CAnonOutput &ao);
+    bool WriteRCTOutput(int64_t i, const CAnonOutput &ao);
+    bool EraseRCTOutput(int64_t i);
+    //! Update the RCT output cache after entries were written or erased through a CDBBatch
+    void CacheRCTOutput(int64_t i, const CAnonOutput &ao);
+    void UncacheRCTOutput(int64_t i);
+
+    bool ReadRCTOutputLink(const CCmpPubKey &pk, int64_t &i);
+    bool WriteRCTOutputLink(const CCmpPubKey &pk, int64_t i);
+    bool EraseRCTOutputLink(const CCmpPubKey &pk);
+
+    bool ReadRCTKeyImage(const CCmpPubKey &ki, uint256 &txhash);
+    bool WriteRCTKeyImage(const CCmpPubKey &ki, const uint256 &txhash);
+    bool EraseRCTKeyImage(const CCmpPubKey &ki);
+};
+
+/**
+ * RingCT index state (anon outputs, output links and key images) kept in memory on top
+ * of the block tree database. Changes accumulate across blocks and are written in one
+ * batch by Flush(), which FlushStateToDisk calls together with the chainstate flush.
+ */
+class CRingCTViewCache
+{
+private:
+    //! A pending write, or a pending erase if fErased is set
+    template <typename V>
+    struct CacheEntry
+    {
+        V value;
+        bool fErased;
+        CacheEntry() : fErased(false) {}
+        CacheEntry(const V& valueIn, bool fErasedIn) : value(valueIn), fErased(fErasedIn) {}
+    };
+
+    CBlockTreeDB *base;
+    mutable CCriticalSection cs_rctview;
+    std::map<int64_t, CacheEntry<CAnonOutput> > mapOutputs;
+    std::map<CCmpPubKey, CacheEntry<int64_t> > mapOutputLinks;
+    std::map<CCmpPubKey, CacheEntry<uint256> > mapKeyImages;
+
+public:
+    explicit CRingCTViewCache(CBlockTreeDB *baseIn) : base(baseIn) {}
+
     bool ReadRCTOutput(int64_t i, CAnonOutput &ao);
     bool WriteRCTOutput(int64_t i, const CAnonOutput &ao);
     bool EraseRCTOutput(int64_t i);
@@ -115,6 +164,13 @@ public:
     bool ReadRCTKeyImage(const CCmpPubKey &ki, uint256 &txhash);
     bool WriteRCTKeyImage(const CCmpPubKey &ki, const uint256 &txhash);
     bool EraseRCTKeyImage(const CCmpPubKey &ki);
+
+    //! Write all pending changes to the block tree database
+    bool Flush();
+    //! Number of pending changes
+    size_t GetCacheSize() const;
+    //! Calculate the size of the cache (in bytes)
+    size_t DynamicMemoryUsage() const;
 };
 
 /** Zerocoin database (zerocoin/) */
@@ -127,7 +183,14 @@ private:
     CZerocoinDB(const CZerocoinDB&);
     void operator=(const CZerocoinDB&);
 
+    //! Truncated hashes of all pubcoins and serials in the db, so that lookups of unknown ones don't hit disk
+    veil::ZerocoinHashIndex indexPubcoins;
+    veil::ZerocoinHashIndex indexSerials;
+
 public:
+    /** Load the pubcoin and serial hash indexes from the db */
+    bool LoadHashIndex();
+
     /** Write Zerocoin mints to the zerocoinDB in a batch */
     bool WriteCoinMintBatch(const std::map<libzerocoin::PublicCoin, uint256>& mintInfo);
     bool ReadCoinMint(const CBigNum& bnPubcoin, uint256& txHash);
@@ -147,6 +210,11 @@ public:
     bool ReadAccumulatorValue(const uint256& nChecksum, CBigNum& bnValue);
     bool EraseAccumulatorValue(const uint256& nChecksum);
 
+    /** Pubcoin values minted in a block, by (height, denomination), so accumulation doesn't need to read full blocks */
+    bool WriteBlockPubcoinBatch(int nHeight, const uint256& hashBlock, const std::map<libzerocoin::CoinDenomination, std::vector<CBigNum> >& mapPubcoins);
+    bool ReadBlockPubcoins(int nHeight, libzerocoin::CoinDenomination denom, const uint256& hashBlock, std::vector<CBigNum>& vPubcoins);
+    bool EraseBlockPubcoins(int nHeight, libzerocoin::CoinDenomination denom);
+
     /** blacklist **/
     bool WriteBlacklistedOutpoint(const COutPoint& outpoint, int nType);
     bool EraseBlacklistedOutpoint(const COutPoint& outpoint);
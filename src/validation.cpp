@@ -246,6 +246,7 @@ CBlockIndex *pindexBestHeader = nullptr;
 CWaitableCriticalSection g_best_block_mutex;
 CConditionVariable g_best_block_cv;
 uint256 g_best_block;
+std::atomic<int> g_best_block_height{-1};
 int nScriptCheckThreads = 0;
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
@@ -337,6 +338,7 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 std::unique_ptr<CCoinsViewDB> pcoinsdbview;
 std::unique_ptr<CCoinsViewCache> pcoinsTip;
 std::unique_ptr<CBlockTreeDB> pblocktree;
+std::unique_ptr<CRingCTViewCache> prctviewTip;
 std::unique_ptr<CZerocoinDB> pzerocoinDB;
 
 enum class FlushStateMode {
@@ -352,7 +354,8 @@ static void FindFilesToPruneManual(std::set<int>& setFilesToPrune, int nManualPr
 static void FindFilesToPrune(std::set<int>& setFilesToPrune, uint64_t nPruneAfterHeight);
 bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks,
         unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
-        std::vector<CScriptCheck> *pvChecks = nullptr, bool fAnonChecks = true);
+        std::vector<CScriptCheck> *pvChecks = nullptr, bool fAnonChecks = true,
+        std::vector<CMLSAGCheck> *pvMLSAGChecks = nullptr);
 static FILE* OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 
 bool CheckFinalTx(const CTransaction &tx, int flags)
@@ -758,7 +761,7 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
                     uint256 txidKeyImage;
                     if (pool.HaveKeyImage(ki, txidKeyImage))
                         return state.Invalid(false, REJECT_DUPLICATE, "keyimage-already-known");
-                    if (pblocktree->ReadRCTKeyImage(ki, txidKeyImage)) {
+                    if (prctviewTip->ReadRCTKeyImage(ki, txidKeyImage)) {
                         LogPrint(BCLog::NET, "%s: Key image in tx %s\n", __func__, txidKeyImage.GetHex());
                         return state.Invalid(false, REJECT_DUPLICATE, "bad-anonin-dup-keyimage");
                     }
@@ -883,6 +886,12 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
             }
         }
 
+        // Start verifying the zerocoin spend proofs on the batch verification threads, the result is collected
+        // once the remaining checks are done
+        CCheckQueueControl<CSerialNumberSoKCheck> controlProofs(!vProofs.empty() ? GetBatchVerifyQueue() : nullptr);
+        if (!vProofs.empty())
+            QueueBatchVerify(&vProofs, controlProofs);
+
         if (!AllAnonOutputsUnknown(tx, state)) // set state.fHasAnonOutput
             return error("%s: already spent anon outputs", __func__); // Already in the blockchain, containing block could have been received before loose tx
 
@@ -1168,7 +1177,7 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
 
         // Last we batch verify zerocoin spend proofs
         if (!vProofs.empty()) {
-            if (!ThreadedBatchVerify(&vProofs)) {
+            if (!controlProofs.Wait()) {
                 return state.DoS(100, error("%s: Failed to verify zerocoinspend proofs for tx %s", __func__,
                                             tx.GetHash().GetHex()), REJECT_INVALID);
             }
@@ -1675,6 +1684,9 @@ void InitScriptExecutionCache() {
  * script checks which are not necessary (eg due to script execution cache hits) are, obviously,
  * not pushed onto pvChecks/run.
  *
+ * If pvMLSAGChecks is not nullptr, the ring signatures of anon inputs are pushed onto it instead of
+ * being verified inline. Ring members are still looked up and key images checked before returning.
+ *
  * Setting cacheSigStore/cacheFullScriptStore to false will remove elements from the corresponding cache
  * which are matched. This is useful for checking blocks where we will likely never need the cache
  * entry again.
@@ -1683,7 +1695,7 @@ void InitScriptExecutionCache() {
  */
 bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks,
         unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata,
-        std::vector<CScriptCheck> *pvChecks, bool fAnonChecks)
+        std::vector<CScriptCheck> *pvChecks, bool fAnonChecks, std::vector<CMLSAGCheck> *pvMLSAGChecks)
 {
     if (!tx.IsCoinBase())
     {
@@ -1773,10 +1785,19 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
                 }
             }
 
-            if (fHasAnonInput && fAnonChecks && !VerifyMLSAG(tx, state))
-                return false;
+            if (fHasAnonInput && fAnonChecks) {
+                if (pvMLSAGChecks) {
+                    CMLSAGCheck check;
+                    if (!GetMLSAGCheck(tx, state, check))
+                        return false;
+                    pvMLSAGChecks->push_back(CMLSAGCheck());
+                    check.swap(pvMLSAGChecks->back());
+                } else if (!VerifyMLSAG(tx, state)) {
+                    return false;
+                }
+            }
 
-            if (cacheFullScriptStore && !pvChecks) {
+            if (cacheFullScriptStore && !pvChecks && !pvMLSAGChecks) {
                 // We executed all of the provided scripts, and were told to
                 // cache the result. Do so now.
                 scriptExecutionCache.insert(hashCacheEntry);
@@ -1962,6 +1983,7 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
                 }
 
                 pzerocoinDB->EraseCoinMint(coin.getValue());
+                pzerocoinDB->EraseBlockPubcoins(pindex->nHeight, coin.getDenomination());
 
                 uint256 hashPubcoin = GetPubCoinHash(coin.getValue());
                 if (blacklist::ContainsPubcoinHash(hashPubcoin)) {
@@ -1985,7 +2007,7 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
                     view.nLastRCTOutput = pindex->nAnonOutputs;
                     // Verify data matches
                     CAnonOutput ao;
-                    if (!pblocktree->ReadRCTOutput(view.nLastRCTOutput, ao)) {
+                    if (!prctviewTip->ReadRCTOutput(view.nLastRCTOutput, ao)) {
                         error("%s: RCT output missing, txn %s, %d, index %d.", __func__, hash.ToString(), k, view.nLastRCTOutput);
                         if (!view.fForceDisconnect)
                             return DISCONNECT_FAILED;
@@ -2136,6 +2158,20 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+static CCheckQueue<CMLSAGCheck> mlsagcheckqueue(32);
+
+void ThreadMLSAGCheck() {
+    RenameThread("veil-mlsagch");
+    mlsagcheckqueue.Thread();
+}
+
+static CCheckQueue<CRangeProofCheck> rangeproofcheckqueue(64);
+
+void ThreadRangeProofCheck() {
+    RenameThread("veil-rangech");
+    rangeproofcheckqueue.Thread();
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2408,6 +2444,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     CBlockUndo blockundo;
 
     CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
+    CCheckQueueControl<CMLSAGCheck> controlMLSAG(fScriptChecks && nScriptCheckThreads ? &mlsagcheckqueue : nullptr);
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
@@ -2636,12 +2673,15 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         txdata.emplace_back(tx);
         if (!tx.IsCoinBase()) {
             std::vector<CScriptCheck> vChecks;
+            std::vector<CMLSAGCheck> vMLSAGChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
-            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr))
+            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i],
+                    nScriptCheckThreads ? &vChecks : nullptr, true, nScriptCheckThreads ? &vMLSAGChecks : nullptr))
                 return error("ConnectBlock(): CheckInputs on %s failed with %s",
                     tx.GetHash().ToString(), FormatStateMessage(state));
 
             control.Add(vChecks);
+            controlMLSAG.Add(vMLSAGChecks);
 
             blockundo.vtxundo.push_back(CTxUndo());
             UpdateCoins(tx, view, blockundo.vtxundo.back(), pindex->nHeight);
@@ -2705,7 +2745,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                 CTxOutRingCT *txout = (CTxOutRingCT*)tx.vpout[k].get();
 
                 int64_t nTestExists;
-                if (!fSkipComputation && !fVerifyingDB && pblocktree->ReadRCTOutputLink(txout->pk, nTestExists)) {
+                if (!fSkipComputation && !fVerifyingDB && prctviewTip->ReadRCTOutputLink(txout->pk, nTestExists)) {
                     control.Wait();
 
                     if (nTestExists > pindex->pprev->nAnonOutputs) {
@@ -2742,19 +2782,6 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     // Skip signature verification if it's already been done or if the block height is below a checkpoint height
     bool fSkipSigVerify = fSkipComputation;
-    int64_t nTimeSigVerify = GetTimeMicros();
-    if (!fSkipSigVerify && !vProofs.empty()) {
-        if (!ThreadedBatchVerify(&vProofs)) {
-            return state.DoS(100, error("%s: Failed to verify zerocoinspend proofs for block=%s height=%d", __func__,
-                                        block.GetHash().GetHex(), pindex->nHeight), REJECT_INVALID);
-        }
-
-        //Global tracker for already validated proofs
-        for (const uint256& txid : vTxidProofs)
-            setBatchVerified.emplace(txid);
-    }
-    nTimeSigVerify = GetTimeMicros() - nTimeSigVerify;
-    nTimeZerocoinSpendCheck += nTimeSigVerify;
 
     //Track zerocoin money supply in the block index
     if (!AddZerocoinsToIndex(pindex, block, mapSpends, mapMints, fJustCheck))
@@ -2864,8 +2891,23 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     nTimeAccumulate = GetTimeMicros() - nTimeAccumulate;
     LogPrint(BCLog::BENCH, "    - Accumulate zerocoinmints in: %.2fms\n", MILLI * nTimeAccumulate);
 
+    //The proofs are verified on the batch verification threads while the script and MLSAG checks finish
+    CCheckQueueControl<CSerialNumberSoKCheck> controlProofs(!fSkipSigVerify && !vProofs.empty() ? GetBatchVerifyQueue() : nullptr);
+    if (!fSkipSigVerify && !vProofs.empty())
+        QueueBatchVerify(&vProofs, controlProofs);
+
     if (!control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
+    if (!controlMLSAG.Wait())
+        return state.DoS(100, error("%s: MLSAG CheckQueue failed", __func__), REJECT_INVALID, "verify-mlsag-failed");
+    if (!controlProofs.Wait())
+        return state.DoS(100, error("%s: Failed to verify zerocoinspend proofs for block=%s height=%d", __func__,
+                                    block.GetHash().GetHex(), pindex->nHeight), REJECT_INVALID);
+    if (!fSkipSigVerify) {
+        //Global tracker for already validated proofs
+        for (const uint256& txid : vTxidProofs)
+            setBatchVerified.emplace(txid);
+    }
 
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint(BCLog::BENCH, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1, MILLI * (nTime4 - nTime2), nInputs <= 1 ? 0 : MILLI * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * MICRO, nTimeVerify * MILLI / nBlocksTotal);
@@ -2900,6 +2942,13 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     // Flush spend/mint info to disk
     if (!pzerocoinDB->WriteCoinSpendBatch(mapSpends)) return state.Error(("Failed to record coin serials to database"));
     if (!pzerocoinDB->WriteCoinMintBatch(mapMints)) return state.Error(("Failed to record new mints to database"));
+    if (!mapMints.empty()) {
+        std::map<libzerocoin::CoinDenomination, std::vector<CBigNum> > mapBlockPubcoins;
+        for (const auto& mintPair : mapMints)
+            mapBlockPubcoins[mintPair.first.getDenomination()].emplace_back(mintPair.first.getValue());
+        if (!pzerocoinDB->WriteBlockPubcoinBatch(pindex->nHeight, pindex->GetBlockHash(), mapBlockPubcoins))
+            return state.Error(("Failed to record block pubcoins to database"));
+    }
     if (pindex->nHeight >= Params().HeightLightZerocoin()) {
         if (!pzerocoinDB->WritePubcoinSpendBatch(mapSpentPubcoinsInBlock, pindex->GetBlockHash()) )
             return state.Error(("Failed to record new pubcoinspends to database"));
@@ -2912,6 +2961,10 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     if (!WriteUndoDataForBlock(blockundo, state, pindex, chainparams))
         return false;
 
+    // Compute the stake modifier entropy of a PoW block before it joins the chain, it is written out with the block index
+    if (pindex->SetModifierPoWHash())
+        setDirtyBlockIndex.insert(pindex);
+
     if (!pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
         pindex->RaiseValidity(BLOCK_VALID_SCRIPTS);
         setDirtyBlockIndex.insert(pindex);
@@ -2977,7 +3030,7 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
             nLastFlush = nNow;
         }
         int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
-        int64_t cacheSize = pcoinsTip->DynamicMemoryUsage();
+        int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() + prctviewTip->DynamicMemoryUsage();
         int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
         // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
         bool fCacheLarge = mode == FlushStateMode::PERIODIC && cacheSize > std::max((9 * nTotalSpace) / 10, nTotalSpace - MAX_BLOCK_COINSDB_USAGE * 1024 * 1024);
@@ -3028,6 +3081,9 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
             // overwrite one. Still, use a conservative safety factor of 2.
             if (!CheckDiskSpace(48 * 2 * 2 * pcoinsTip->GetCacheSize()))
                 return state.Error("out of disk space");
+            // Flush the RingCT index first, so that it is never behind the chainstate on disk.
+            if (!prctviewTip->Flush())
+                return AbortNode(state, "Failed to write to RingCT index");
             // Flush the chainstate (which may refer to block index entries).
             if (!pcoinsTip->Flush())
                 return AbortNode(state, "Failed to write to coin database");
@@ -3079,32 +3135,28 @@ bool FlushView(CCoinsViewCache *view, CValidationState& state, bool fDisconnecti
 
     if (fDisconnecting) {
         for (auto &it : view->keyImages)
-            if (!pblocktree->EraseRCTKeyImage(it.first))
+            if (!prctviewTip->EraseRCTKeyImage(it.first))
                 return error("%s: EraseRCTKeyImage failed, txn %s.", __func__, it.second.ToString());
 
         if (view->anonOutputLinks.size() > 0) {
             for (auto &it : view->anonOutputLinks) {
-                if (!pblocktree->EraseRCTOutput(it.second))
+                if (!prctviewTip->EraseRCTOutput(it.second))
                     return error("%s: EraseRCTOutput failed.", __func__);
 
-                if (!pblocktree->EraseRCTOutputLink(it.first))
+                if (!prctviewTip->EraseRCTOutputLink(it.first))
                     return error("%s: EraseRCTOutput failed.", __func__);
             }
         }
     } else {
-        CDBBatch batch(*pblocktree);
-
+        // Written to disk together with the chainstate in FlushStateToDisk
         for (auto &it : view->keyImages)
-            batch.Write(std::make_pair(DB_RCTKEYIMAGE, it.first), it.second);
+            prctviewTip->WriteRCTKeyImage(it.first, it.second);
 
         for (auto &it : view->anonOutputs)
-            batch.Write(std::make_pair(DB_RCTOUTPUT, it.first), it.second);
+            prctviewTip->WriteRCTOutput(it.first, it.second);
 
         for (auto &it : view->anonOutputLinks)
-            batch.Write(std::make_pair(DB_RCTOUTPUT_LINK, it.first), it.second);
-
-        if (!pblocktree->WriteBatch(batch))
-            return error("%s: Write RCT outputs failed.", __func__);
+            prctviewTip->WriteRCTOutputLink(it.first, it.second);
     }
 
     view->nLastRCTOutput = 0;
@@ -3143,6 +3195,7 @@ void static UpdateTip(const CBlockIndex *pindexNew, const CChainParams& chainPar
         g_best_block = pindexNew->GetBlockHash();
         g_best_block_cv.notify_all();
     }
+    g_best_block_height = pindexNew->nHeight;
 
     std::string warningMessages;
     if (!IsInitialBlockDownload())
@@ -4178,11 +4231,22 @@ bool CheckBlock(const CBlock& block, CValidationState& state, const Consensus::P
 
     // Check transactions
     int64_t nTimeCheckTx = GetTimeMicros();
+    std::atomic<const char*> pRangeProofRejectReason{nullptr};
+    CCheckQueueControl<CRangeProofCheck> control(nScriptCheckThreads ? &rangeproofcheckqueue : nullptr);
     for (const auto& tx : block.vtx) {
-        if (!CheckTransaction(*tx, state, fSkipComputation))
+        std::vector<CRangeProofCheck> vChecks;
+        if (!CheckTransaction(*tx, state, fSkipComputation, nScriptCheckThreads ? &vChecks : nullptr))
             return state.Invalid(false, state.GetRejectCode(), state.GetRejectReason(),
                                  strprintf("Transaction check failed (tx hash %s) %s", tx->GetHash().ToString(),
                                            state.GetDebugMessage()));
+        for (auto& check : vChecks)
+            check.SetFirstRejectReason(&pRangeProofRejectReason);
+        control.Add(vChecks);
+    }
+    if (!control.Wait()) {
+        const char *pRejectReason = pRangeProofRejectReason.load();
+        return state.DoS(100, false, REJECT_INVALID, pRejectReason ? pRejectReason : "bad-txns-rangeproof-verify", false,
+                         "range proof check failed");
     }
     LogPrint(BCLog::BENCH, "    -   CheckTransaction(): %.2fms\n", 0.001 * (GetTimeMicros() - nTimeCheckTx));
     unsigned int nSigOps = 0;
@@ -5314,6 +5378,20 @@ bool CChainState::LoadBlockIndex(const Consensus::Params& consensus_params, CBlo
             pindexBestHeader = pindex;
     }
 
+    // Indexes written before hashModifierPoW existed are filled here for the blocks the next stake modifiers sample,
+    // and written back with the next flush. Older blocks compute the hash when they are needed.
+    int64_t nModifiersSet = 0;
+    CBlockIndex* pindexValid = pindexBestHeader;
+    while (pindexValid && !pindexValid->IsValid(BLOCK_VALID_SCRIPTS))
+        pindexValid = pindexValid->pprev;
+    for (CBlockIndex* pindex = pindexValid; pindex && pindexValid->nHeight - pindex->nHeight < MODIFIER_BACKFILL_DEPTH; pindex = pindex->pprev) {
+        if (pindex->SetModifierPoWHash()) {
+            setDirtyBlockIndex.insert(pindex);
+            nModifiersSet++;
+        }
+    }
+    LogPrintf("%s: computed the modifier hash of %d PoW blocks\n", __func__, nModifiersSet);
+
     return true;
 }
 
@@ -5393,6 +5471,7 @@ bool LoadChainTip(const CChainParams& chainparams)
         return false;
     }
     chainActive.SetTip(pindex);
+    g_best_block_height = pindex->nHeight;
 
     g_chainstate.PruneBlockIndexCandidates();
 
@@ -35,6 +35,7 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CRingCTViewCache;
 class CZerocoinDB;
 class CChainParams;
 class CCoinsViewDB;
@@ -119,6 +120,9 @@ static const int64_t BLOCK_DOWNLOAD_TIMEOUT_PER_PEER = 500000;
 static const int64_t DEFAULT_MAX_TIP_AGE = 24 * 60 * 60;
 /** Maximum age of our tip in seconds for us to be considered current for fee estimation */
 static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 3 * 60 * 60;
+/** PoW blocks this deep below the best header get their stake modifier hash filled in at startup. The modifier
+ *  samples blocks 100 to 154 below the tip, older blocks compute the hash on demand. */
+static const int MODIFIER_BACKFILL_DEPTH = 200;
 
 /** Default for -permitbaremultisig */
 static const bool DEFAULT_PERMIT_BAREMULTISIG = true;
@@ -161,6 +165,8 @@ extern const std::string strMessageMagic;
 extern CWaitableCriticalSection g_best_block_mutex;
 extern CConditionVariable g_best_block_cv;
 extern uint256 g_best_block;
+//! Height of chainActive's tip, for threads that watch for new blocks without holding cs_main
+extern std::atomic<int> g_best_block_height;
 extern std::atomic_bool fImporting;
 extern std::atomic_bool fReindex;
 extern std::atomic_bool fReindexChainState;
@@ -278,6 +284,10 @@ bool LoadChainTip(const CChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the ring signature (MLSAG) checking thread */
+void ThreadMLSAGCheck();
+/** Run an instance of the range proof checking thread */
+void ThreadRangeProofCheck();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Check whether both headers and blocks are synced **/
@@ -517,6 +527,9 @@ extern std::unique_ptr<CCoinsViewCache> pcoinsTip;
 /** Global variable that points to the active block tree (protected by cs_main) */
 extern std::unique_ptr<CBlockTreeDB> pblocktree;
 
+/** Global variable that points to the active RingCT index cache on top of pblocktree (protected by cs_main) */
+extern std::unique_ptr<CRingCTViewCache> prctviewTip;
+
 /** Global variable that points to the active zerocoin database (protected by cs_main) */
 extern std::unique_ptr<CZerocoinDB> pzerocoinDB;
 
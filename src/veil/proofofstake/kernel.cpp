@@ -17,8 +17,14 @@
 #include "stakeinput.h"
 #include "veil/zerocoin/zchain.h"
 #include "libzerocoin/bignum.h"
+#include "crypto/common.h"
+#include <checkqueue.h>
 #include <versionbits.h>
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+
 using namespace std;
 
 //test hash vs target
@@ -35,13 +41,37 @@ bool stakeTargetHit(arith_uint256 hashProofOfStake, int64_t nValueIn, arith_uint
     return hashProofOfStake < bnTarget;
 }
 
+CStakeKernelHasher::CStakeKernelHasher(uint64_t nStakeModifier, unsigned int nTimeBlockFrom, const CDataStream& ssUniqueID)
+{
+    CDataStream ss(SER_GETHASH, 0);
+    ss << nStakeModifier << nTimeBlockFrom << ssUniqueID;
+    sha.Write((const unsigned char*)ss.data(), ss.size());
+}
+
+// Same as Hash() of the stream nStakeModifier << nTimeBlockFrom << ssUniqueID << nTimeTx
+uint256 CStakeKernelHasher::GetHash(unsigned int nTimeTx) const
+{
+    unsigned char time[sizeof(uint32_t)];
+    WriteLE32(time, nTimeTx);
+
+    unsigned char buf[CSHA256::OUTPUT_SIZE];
+    CSHA256(sha).Write(time, sizeof(time)).Finalize(buf);
+
+    uint256 hash;
+    CSHA256().Write(buf, sizeof(buf)).Finalize(hash.begin());
+    return hash;
+}
+
 bool CheckStake(const CDataStream& ssUniqueID, CAmount nValueIn, const uint64_t nStakeModifier, const uint256& bnTarget,
                 unsigned int nTimeBlockFrom, unsigned int& nTimeTx, uint256& hashProofOfStake)
 {
-    CDataStream ss(SER_GETHASH, 0);
-    ss << nStakeModifier << nTimeBlockFrom << ssUniqueID << nTimeTx;
-    hashProofOfStake = Hash(ss.begin(), ss.end());
-    //LogPrintf("%s: modifier:%d nTimeBlockFrom:%d nTimeTx:%d hash:%s\n", __func__, nStakeModifier, nTimeBlockFrom, nTimeTx, hashProofOfStake.GetHex());
+    return CheckStake(CStakeKernelHasher(nStakeModifier, nTimeBlockFrom, ssUniqueID), nValueIn, bnTarget, nTimeTx, hashProofOfStake);
+}
+
+bool CheckStake(const CStakeKernelHasher& hasher, CAmount nValueIn, const uint256& bnTarget, unsigned int nTimeTx, uint256& hashProofOfStake)
+{
+    hashProofOfStake = hasher.GetHash(nTimeTx);
+    //LogPrintf("%s: nTimeTx:%d hash:%s\n", __func__, nTimeTx, hashProofOfStake.GetHex());
 
     return stakeTargetHit(UintToArith256(hashProofOfStake), nValueIn, UintToArith256(bnTarget));
 }
@@ -63,71 +93,194 @@ void WeightStake(CAmount& nValueIn, const libzerocoin::CoinDenomination denom)
 }
 
 std::set<uint256> setFoundStakes;
-bool Stake(CStakeInput* stakeInput, unsigned int nBits, unsigned int nTimeBlockFrom, unsigned int& nTimeTx, const CBlockIndex* pindexBest, uint256& hashProofOfStake, bool fWeightStake)
+
+/** Closure representing one thread's share of a kernel search, which takes inputs until none are left. */
+class CStakeKernelCheck
 {
-    if (nTimeTx < nTimeBlockFrom)
-        return error("%s: nTime violation", __func__);
+private:
+    const std::function<void()>* pfnSearch = nullptr;
 
-    //grab difficulty
-    arith_uint256 bnTargetPerCoinDay;
-    bnTargetPerCoinDay.SetCompact(nBits);
+public:
+    CStakeKernelCheck() {}
+    explicit CStakeKernelCheck(const std::function<void()>* pfnSearchIn) : pfnSearch(pfnSearchIn) {}
 
-    //grab stake modifier
-    uint64_t nStakeModifier = 0;
-    if (!stakeInput->GetModifier(nStakeModifier, pindexBest))
-        return error("failed to get kernel stake modifier");
+    bool operator()()
+    {
+        (*pfnSearch)();
+        return true;
+    }
 
-    bool fSuccess = false;
-    unsigned int nTryTime = 0;
-    int nHeightStart = pindexBest->nHeight;
-    //staking too far into future increases chances of orphan
-    int64_t nMaxTime = (int)GetAdjustedTime() + MAX_FUTURE_BLOCK_TIME - 40;
+    void swap(CStakeKernelCheck& check) { std::swap(pfnSearch, check.pfnSearch); }
+};
 
-    CDataStream ssUniqueID = stakeInput->GetUniqueness();
-    CAmount nValueIn = stakeInput->GetValue();
+static CCheckQueue<CStakeKernelCheck> stakekernelqueue(1);
 
-    //Adjust stake weights to larger denoms
-    if (fWeightStake)
-        WeightStake(nValueIn, stakeInput->GetDenomination());
+void ThreadStakeKernelSearch()
+{
+    RenameThread("veil-stakesearch");
+    stakekernelqueue.Thread();
+}
 
-    int nBestHeight = pindexBest->nHeight;
-    uint256 hashBestBlock = pindexBest->GetBlockHash();
-    if (!mapStakeHashCounter.count(nBestHeight))
-        mapStakeHashCounter[nBestHeight] = 0;
+/**
+ * Search the stake inputs that are not marked fSearched for a kernel. The inputs are spread over nThreads threads,
+ * this one and the ThreadStakeKernelSearch workers, each trying the timestamps of one input at a time, and the
+ * search stops at the first hit. An input that was interrupted by a hit on another thread continues from where it
+ * stopped on the next call. On success nCandidate, nTimeTx and hashProofOfStake describe the kernel that was found.
+ */
+bool SearchStakeKernels(std::vector<StakeKernelCandidate>& vCandidates, unsigned int nBits, const CBlockIndex* pindexBest, bool fWeightStake, int nThreads, const std::function<bool()>& fnInterrupt, size_t& nCandidate, unsigned int& nTimeTx, uint256& hashProofOfStake)
+{
+    //grab difficulty
+    arith_uint256 bnTargetPerCoinDay;
+    bnTargetPerCoinDay.SetCompact(nBits);
+    const uint256 bnTarget = ArithToUint256(bnTargetPerCoinDay);
 
-    int i = 0;
-    while (true) //iterate the hashing
+    // Everything that stays the same while the timestamps of an input are tried
+    struct KernelInput
     {
-        //new block came in, move on
-        if (chainActive.Height() != nHeightStart)
-            break;
-
-        //hash this iteration
-        nTryTime = nTimeTx + i;
-        if (nTryTime >= nMaxTime - 5)
-            break;
-
-        mapStakeHashCounter[nBestHeight]++;
-        i++;
+        size_t nCandidate;
+        CStakeKernelHasher hasher;
+        CAmount nValueIn;
+    };
+    std::vector<KernelInput> vInputs;
+    for (size_t i = 0; i < vCandidates.size(); i++) {
+        StakeKernelCandidate& candidate = vCandidates[i];
+        if (candidate.fSearched)
+            continue;
 
-        // if stake hash does not meet the target then continue to next iteration
-        if (!CheckStake(ssUniqueID, nValueIn, nStakeModifier, ArithToUint256(bnTargetPerCoinDay), nTimeBlockFrom, nTryTime, hashProofOfStake))
+        if (candidate.nTimeTx < candidate.nTimeBlockFrom) {
+            candidate.fSearched = true;
+            error("%s: nTime violation", __func__);
             continue;
+        }
 
-        if (setFoundStakes.count(hashProofOfStake))
+        //grab stake modifier
+        uint64_t nStakeModifier = 0;
+        if (!candidate.stakeInput->GetModifier(nStakeModifier, pindexBest)) {
+            candidate.fSearched = true;
+            error("failed to get kernel stake modifier");
             continue;
-        setFoundStakes.emplace(hashProofOfStake);
+        }
+
+        CAmount nValueIn = candidate.stakeInput->GetValue();
 
-        fSuccess = true; // if we make it this far then we have successfully created a stake hash
-        nTimeTx = nTryTime;
-        break;
+        //Adjust stake weights to larger denoms
+        if (fWeightStake)
+            WeightStake(nValueIn, candidate.stakeInput->GetDenomination());
+
+        CStakeKernelHasher hasher(nStakeModifier, candidate.nTimeBlockFrom, candidate.stakeInput->GetUniqueness());
+        vInputs.push_back(KernelInput{i, hasher, nValueIn});
     }
 
+    int nHeightStart = pindexBest->nHeight;
+    //staking too far into future increases chances of orphan
+    int64_t nMaxTime = (int)GetAdjustedTime() + MAX_FUTURE_BLOCK_TIME - 40;
+
+    std::atomic<size_t> nNext(0);
+    std::atomic<bool> fStop(false);
+    std::atomic<unsigned int> nHashes(0);
+    std::atomic<unsigned int> nLastTryTime(0);
+    std::mutex mutexFound;
+    bool fSuccess = false;
+
+    std::function<void()> search = [&]() {
+        unsigned int nThreadHashes = 0;
+        unsigned int nTryTime = 0;
+        while (!fStop) {
+            size_t nInput = nNext++;
+            if (nInput >= vInputs.size())
+                break;
+
+            // e.g. the wallet was locked or shutdown was requested
+            if (fnInterrupt && fnInterrupt()) {
+                fStop = true;
+                break;
+            }
+
+            const KernelInput& input = vInputs[nInput];
+            StakeKernelCandidate& candidate = vCandidates[input.nCandidate];
+            int i = 0;
+            while (true) //iterate the hashing
+            {
+                //new block came in, move on
+                if (g_best_block_height != nHeightStart) {
+                    fStop = true;
+                    break;
+                }
+
+                //hash this iteration
+                nTryTime = candidate.nTimeTx + i;
+                if (nTryTime >= nMaxTime - 5) {
+                    candidate.fSearched = true;
+                    break;
+                }
+
+                // another thread found a kernel, continue from here next time
+                if (fStop) {
+                    candidate.nTimeTx = nTryTime;
+                    break;
+                }
+
+                nThreadHashes++;
+                i++;
+
+                // if stake hash does not meet the target then continue to next iteration
+                uint256 hashProof;
+                if (!CheckStake(input.hasher, input.nValueIn, bnTarget, nTryTime, hashProof))
+                    continue;
+
+                std::lock_guard<std::mutex> lock(mutexFound);
+                if (setFoundStakes.count(hashProof))
+                    continue;
+
+                // only the first kernel is used
+                if (fSuccess) {
+                    candidate.nTimeTx = nTryTime;
+                    break;
+                }
+                setFoundStakes.emplace(hashProof);
+
+                fSuccess = true; // if we make it this far then we have successfully created a stake hash
+                fStop = true;
+                candidate.fSearched = true;
+                nCandidate = input.nCandidate;
+                nTimeTx = nTryTime;
+                hashProofOfStake = hashProof;
+                break;
+            }
+        }
+        nHashes += nThreadHashes;
+        unsigned int nLast = nLastTryTime;
+        while (nTryTime > nLast && !nLastTryTime.compare_exchange_weak(nLast, nTryTime)) {}
+    };
+
+    nThreads = std::max(1, std::min(nThreads, (int)vInputs.size()));
+    if (nThreads == 1) {
+        search();
+    } else {
+        CCheckQueueControl<CStakeKernelCheck> control(&stakekernelqueue);
+        std::vector<CStakeKernelCheck> vChecks;
+        for (int i = 0; i < nThreads; i++)
+            vChecks.emplace_back(&search);
+        control.Add(vChecks);
+        control.Wait();
+    }
+
+    mapStakeHashCounter[nHeightStart] += nHashes;
     mapHashedBlocks.clear();
-    mapHashedBlocks[hashBestBlock] = nTryTime; //store a time stamp of when we last hashed on this block
+    mapHashedBlocks[pindexBest->GetBlockHash()] = nLastTryTime; //store a time stamp of when we last hashed on this block
     return fSuccess;
 }
 
+bool Stake(CStakeInput* stakeInput, unsigned int nBits, unsigned int nTimeBlockFrom, unsigned int& nTimeTx, const CBlockIndex* pindexBest, uint256& hashProofOfStake, bool fWeightStake)
+{
+    if (nTimeTx < nTimeBlockFrom)
+        return error("%s: nTime violation", __func__);
+
+    std::vector<StakeKernelCandidate> vCandidates{StakeKernelCandidate(stakeInput, nTimeBlockFrom, nTimeTx)};
+    size_t nCandidate;
+    return SearchStakeKernels(vCandidates, nBits, pindexBest, fWeightStake, 1, nullptr, nCandidate, nTimeTx, hashProofOfStake);
+}
+
 // Check kernel hash target and coinstake signature
 bool CheckProofOfStake(CBlockIndex* pindexCheck, const CTransactionRef txRef, const uint32_t& nBits, const unsigned int& nTimeBlock, uint256& hashProofOfStake, std::unique_ptr<CStakeInput>& stake)
 {
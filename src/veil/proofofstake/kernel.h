@@ -6,11 +6,50 @@
 #ifndef BITCOIN_KERNEL_H
 #define BITCOIN_KERNEL_H
 
+#include "crypto/sha256.h"
 #include "validation.h"
 #include "stakeinput.h"
 
+#include <functional>
+#include <vector>
+
+//! -stakingthreads default, the number of threads that search for a stake kernel
+static const int DEFAULT_STAKING_THREADS = 1;
+
+/**
+ * Kernel hash of a stake input for a changing nTimeTx. The serialized nStakeModifier, nTimeBlockFrom and
+ * uniqueness are written into a SHA256 midstate once, each timestamp only finishes the hash from there.
+ */
+class CStakeKernelHasher
+{
+private:
+    CSHA256 sha;
+
+public:
+    CStakeKernelHasher(uint64_t nStakeModifier, unsigned int nTimeBlockFrom, const CDataStream& ssUniqueID);
+    uint256 GetHash(unsigned int nTimeTx) const;
+};
+
+/** A stake input that is searched for a kernel, starting from nTimeTx. */
+struct StakeKernelCandidate
+{
+    CStakeInput* stakeInput;
+    unsigned int nTimeBlockFrom;
+    unsigned int nTimeTx;
+    //! Set once every timestamp of this input has been tried, or a kernel was found for it
+    bool fSearched;
+
+    StakeKernelCandidate(CStakeInput* stakeInputIn, unsigned int nTimeBlockFromIn, unsigned int nTimeTxIn)
+        : stakeInput(stakeInputIn), nTimeBlockFrom(nTimeBlockFromIn), nTimeTx(nTimeTxIn), fSearched(false) {}
+};
+
 bool CheckStake(const CDataStream& ssUniqueID, CAmount nValueIn, const uint64_t nStakeModifier, const uint256& bnTarget, unsigned int nTimeBlockFrom, unsigned int& nTimeTx, uint256& hashProofOfStake);
+bool CheckStake(const CStakeKernelHasher& hasher, CAmount nValueIn, const uint256& bnTarget, unsigned int nTimeTx, uint256& hashProofOfStake);
 bool stakeTargetHit(arith_uint256 hashProofOfStake, int64_t nValueIn, arith_uint256 bnTargetPerCoinDay);
+/** Run an instance of the stake kernel search thread, SearchStakeKernels uses -stakingthreads - 1 of them */
+void ThreadStakeKernelSearch();
+//! fnInterrupt is called before each input is searched, and stops the search when it returns true
+bool SearchStakeKernels(std::vector<StakeKernelCandidate>& vCandidates, unsigned int nBits, const CBlockIndex* pindexBest, bool fWeightStake, int nThreads, const std::function<bool()>& fnInterrupt, size_t& nCandidate, unsigned int& nTimeTx, uint256& hashProofOfStake);
 bool Stake(CStakeInput* stakeInput, unsigned int nBits, unsigned int nTimeBlockFrom, unsigned int& nTimeTx, const CBlockIndex* pindexBest, uint256& hashProofOfStake, bool fWeightStake);
 bool CheckProofOfStake(CBlockIndex* pindexCheck, const CTransactionRef txRef, const uint32_t& nBits, const unsigned int& nTimeBlock, uint256& hashProofOfStake, std::unique_ptr<CStakeInput>& stake);
 
@@ -11,6 +11,7 @@
 #include "wallet/deterministicmint.h"
 #include "validation.h"
 #include "stakeinput.h"
+#include "veil/lru_cache.h"
 #include "veil/proofofstake/kernel.h"
 #ifdef ENABLE_WALLET
 #include "wallet/wallet.h"
@@ -18,6 +19,10 @@
 
 typedef std::vector<unsigned char> valtype;
 
+// After HeightLightZerocoin the modifier only depends on the block it is built on, so it is shared by every
+// stake input. Keyed by block hash, this holds the tip plus the few competing tips that a reorg may bring.
+static veil::SimpleLRUCache<uint256, uint64_t, BlockHasher> cacheStakeModifiers(16);
+
 ZerocoinStake::ZerocoinStake(const libzerocoin::CoinSpend& spend)
 {
     this->nChecksum = spend.getAccumulatorChecksum();
@@ -95,14 +100,8 @@ int ZerocoinStake::HeightToModifierHeight(int nHeight)
 uint256 GetHashFromIndex(const CBlockIndex* pindexSample)
 {
     if (pindexSample->IsProofOfWork()) {
-        // By using the pindex time and checking it against the PoWUpdateTimestamp we can tell the code to either
-        // set the veildatahash to all zeros if True is passed, or to do nothing if False is passed.
-        // When mining to the local wallet aggressively we have found that occassionaly the memory of the pindex block data
-        // shows that the veildatahash is not zero (0000xxxx). This made the wallet not accept valid PoS blocks from the chain tip
-        // and allowed the wallet to fork off. This fix allows us to pass in the boolean that is used to tell the code
-        // to set the veildatahash to zero manually for us. This can be done only after the PoWUpdateTimestamp as veildatahash isn't used
-        // in the block hash calculation after that timestamp.
-        return pindexSample->GetX16RTPoWHash(pindexSample->nTime >= Params().PowUpdateTimestamp());
+        // The X16RT hash is only computed once per block and kept with the block index
+        return pindexSample->GetModifierPoWHash();
     }
 
     uint256 hashProof = pindexSample->GetBlockPoSHash();
@@ -155,6 +154,9 @@ bool ZerocoinStake::GetModifier(uint64_t& nStakeModifier, const CBlockIndex* pin
 
     uint256 hashModifier;
     if (pindexChainPrev->nHeight >= Params().HeightLightZerocoin()) {
+        if (cacheStakeModifiers.get(pindexChainPrev->GetBlockHash(), nStakeModifier))
+            return true;
+
         //Use a new modifier that is less able to be "grinded"
         int nHeightChain = pindexChainPrev->nHeight;
         int nHeightPrevious = nHeightChain - 100;
@@ -176,6 +178,7 @@ bool ZerocoinStake::GetModifier(uint64_t& nStakeModifier, const CBlockIndex* pin
             hashModifier = Hash(hashModifier.begin(), hashModifier.end(), hashSample.begin(), hashSample.end());
         }
         nStakeModifier = UintToArith256(hashModifier).GetLow64();
+        cacheStakeModifiers.set(pindexChainPrev->GetBlockHash(), nStakeModifier);
         return true;
     }
 
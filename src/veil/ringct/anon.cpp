@@ -19,12 +19,10 @@
 #include <txmempool.h>
 
 
-bool VerifyMLSAG(const CTransaction &tx, CValidationState &state)
+bool GetMLSAGCheck(const CTransaction &tx, CValidationState &state, CMLSAGCheck &check)
 {
-    int rv;
     std::set<int64_t> setHaveI; // Anon prev-outputs can only be used once per transaction.
     std::set<CCmpPubKey> setHaveKI;
-    bool fSplitCommitments = tx.vin.size() > 1;
 
     size_t nStandard = 0, nCt = 0, nRingCT = 0;
     CAmount nPlainValueOut = tx.GetPlainValueOut(nStandard, nCt, nRingCT);
@@ -44,11 +42,12 @@ bool VerifyMLSAG(const CTransaction &tx, CValidationState &state)
             return state.DoS(100, false, REJECT_INVALID, "bad-plain-commitment");
     }
 
-    std::vector<const uint8_t*> vpInputSplitCommits;
-    if (fSplitCommitments)
-        vpInputSplitCommits.reserve(tx.vin.size());
+    std::vector<std::vector<uint8_t> > vvM;
+    std::vector<std::vector<secp256k1_pedersen_commitment> > vvCommitments;
+    vvM.reserve(tx.vin.size());
+    vvCommitments.reserve(tx.vin.size());
 
-    uint256 hashOutputs = tx.GetOutputsHash();
+    bool fSplitCommitments = tx.vin.size() > 1;
     for (const auto &txin : tx.vin) {
         if (!txin.IsAnonInput())
             return state.DoS(100, false, REJECT_MALFORMED, "bad-anon-input");
@@ -83,25 +82,12 @@ bool VerifyMLSAG(const CTransaction &tx, CValidationState &state)
         if (vDL.size() != (1 + (nInputs+1) * nRingSize) * 32 + (fSplitCommitments ? 33 : 0))
             return state.DoS(100, false, REJECT_MALFORMED, "bad-anonin-sig-size");
 
-        std::vector<uint8_t> vM(nCols * nRows * 33);
+        vvM.emplace_back(nCols * nRows * 33);
+        std::vector<uint8_t> &vM = vvM.back();
 
-        std::vector<secp256k1_pedersen_commitment> vCommitments;
+        vvCommitments.emplace_back();
+        std::vector<secp256k1_pedersen_commitment> &vCommitments = vvCommitments.back();
         vCommitments.reserve(nCols * nInputs);
-        std::vector<const uint8_t*> vpOutCommits;
-        std::vector<const uint8_t*> vpInCommits(nCols * nInputs);
-
-        if (fSplitCommitments) {
-            vpOutCommits.push_back(&vDL[(1 + (nInputs+1) * nRingSize) * 32]);
-            vpInputSplitCommits.push_back(&vDL[(1 + (nInputs+1) * nRingSize) * 32]);
-        } else {
-            vpOutCommits.push_back(plainCommitment.data);
-
-            secp256k1_pedersen_commitment *pc;
-            for (const auto &txout : tx.vpout) {
-                if ((pc = txout->GetPCommitment()))
-                    vpOutCommits.push_back(pc->data);
-            }
-        }
 
         size_t ofs = 0, nB = 0;
         for (size_t k = 0; k < nInputs; ++k) {
@@ -116,13 +102,12 @@ bool VerifyMLSAG(const CTransaction &tx, CValidationState &state)
                     return state.DoS(100, false, REJECT_MALFORMED, "bad-anonin-dup-i");
 
                 CAnonOutput ao;
-                if (!pblocktree->ReadRCTOutput(nIndex, ao)) {
+                if (!prctviewTip->ReadRCTOutput(nIndex, ao)) {
                     return state.DoS(100, false, REJECT_MALFORMED, "bad-anonin-unknown-i");
                 }
 
                 memcpy(&vM[(i + k * nCols) * 33], ao.pubkey.begin(), 33);
                 vCommitments.push_back(ao.commitment);
-                vpInCommits[i + k * nCols] = vCommitments.back().data;
             }
         }
 
@@ -139,19 +124,75 @@ bool VerifyMLSAG(const CTransaction &tx, CValidationState &state)
 //                return state.DoS(100, false, REJECT_INVALID, "bad-anonin-dup-ki-mempool");
 //            }
 
-            if (pblocktree->ReadRCTKeyImage(ki, txhashKI) && txhashKI != txhash) {
+            if (prctviewTip->ReadRCTKeyImage(ki, txhashKI) && txhashKI != txhash) {
                 LogPrintf("%s: Key image in tx %s\n", __func__, txhashKI.GetHex());
                 return state.DoS(100, false, REJECT_INVALID, "bad-anonin-dup-keyimage");
             }
         }
+    }
+
+    CMLSAGCheck checkOut(tx, plainCommitment, vvM, vvCommitments);
+    check.swap(checkOut);
+    return true;
+}
+
+bool CMLSAGCheck::operator()()
+{
+    const CTransaction &tx = *ptxTo;
+    int rv;
+    bool fSplitCommitments = tx.vin.size() > 1;
+
+    std::vector<const uint8_t*> vpInputSplitCommits;
+    if (fSplitCommitments)
+        vpInputSplitCommits.reserve(tx.vin.size());
+
+    uint256 hashOutputs = tx.GetOutputsHash();
+    for (size_t n = 0; n < tx.vin.size(); ++n) {
+        const CTxIn &txin = tx.vin[n];
+
+        uint32_t nInputs, nRingSize;
+        txin.GetAnonInfo(nInputs, nRingSize);
+
+        size_t nCols = nRingSize;
+        size_t nRows = nInputs + 1;
+
+        const std::vector<uint8_t> &vKeyImages = txin.scriptData.stack[0];
+        const std::vector<uint8_t> &vDL = txin.scriptWitness.stack[1];
+
+        std::vector<uint8_t> &vM = vvM[n];
+        const std::vector<secp256k1_pedersen_commitment> &vCommitments = vvCommitments[n];
+
+        std::vector<const uint8_t*> vpOutCommits;
+        std::vector<const uint8_t*> vpInCommits(nCols * nInputs);
+        for (size_t i = 0; i < vCommitments.size(); ++i)
+            vpInCommits[i] = vCommitments[i].data;
+
+        if (fSplitCommitments) {
+            vpOutCommits.push_back(&vDL[(1 + (nInputs+1) * nRingSize) * 32]);
+            vpInputSplitCommits.push_back(&vDL[(1 + (nInputs+1) * nRingSize) * 32]);
+        } else {
+            vpOutCommits.push_back(plainCommitment.data);
+
+            secp256k1_pedersen_commitment *pc;
+            for (const auto &txout : tx.vpout) {
+                if ((pc = txout->GetPCommitment()))
+                    vpOutCommits.push_back(pc->data);
+            }
+        }
 
         if (0 != (rv = secp256k1_prepare_mlsag(&vM[0], nullptr, vpOutCommits.size(), vpOutCommits.size(), nCols, nRows,
-                &vpInCommits[0], &vpOutCommits[0], nullptr)))
-            return state.DoS(100, error("%s: prepare-mlsag-failed %d", __func__, rv), REJECT_INVALID, "prepare-mlsag-failed");
+                &vpInCommits[0], &vpOutCommits[0], nullptr))) {
+            strRejectReason = "prepare-mlsag-failed";
+            nError = rv;
+            return false;
+        }
 
         if (0 != (rv = secp256k1_verify_mlsag(secp256k1_ctx_blind, hashOutputs.begin(), nCols, nRows, &vM[0], &vKeyImages[0],
-                &vDL[0], &vDL[32])))
-            return state.DoS(100, error("%s: verify-mlsag-failed %d", __func__, rv), REJECT_INVALID, "verify-mlsag-failed");
+                &vDL[0], &vDL[32]))) {
+            strRejectReason = "verify-mlsag-failed";
+            nError = rv;
+            return false;
+        }
     }
 
     // Verify commitment sums match
@@ -168,13 +209,29 @@ bool VerifyMLSAG(const CTransaction &tx, CValidationState &state)
 
         if (1 != (rv = secp256k1_pedersen_verify_tally(secp256k1_ctx_blind,
                 (const secp256k1_pedersen_commitment* const*)vpInputSplitCommits.data(), vpInputSplitCommits.size(),
-                (const secp256k1_pedersen_commitment* const*)vpOutCommits.data(), vpOutCommits.size())))
-            return state.DoS(100, error("%s: verify-commit-tally-failed %d", __func__, rv), REJECT_INVALID, "verify-commit-tally-failed");
+                (const secp256k1_pedersen_commitment* const*)vpOutCommits.data(), vpOutCommits.size()))) {
+            strRejectReason = "verify-commit-tally-failed";
+            nError = rv;
+            return false;
+        }
     }
 
     return true;
 }
 
+bool VerifyMLSAG(const CTransaction &tx, CValidationState &state)
+{
+    CMLSAGCheck check;
+    if (!GetMLSAGCheck(tx, state, check))
+        return false;
+
+    if (!check())
+        return state.DoS(100, error("%s: %s %d", __func__, check.GetRejectReason(), check.GetError()), REJECT_INVALID,
+                check.GetRejectReason());
+
+    return true;
+}
+
 bool AddKeyImagesToMempool(const CTransaction &tx, CTxMemPool &pool)
 {
     for (const CTxIn &txin : tx.vin) {
@@ -235,10 +292,10 @@ bool AllAnonOutputsUnknown(const CTransaction &tx, CValidationState &state)
         CTxOutRingCT *txout = (CTxOutRingCT*)tx.vpout[k].get();
 
         int64_t nTestExists;
-        if (pblocktree->ReadRCTOutputLink(txout->pk, nTestExists)) {
+        if (prctviewTip->ReadRCTOutputLink(txout->pk, nTestExists)) {
             COutPoint op(tx.GetHash(), k);
             CAnonOutput ao;
-            if (!pblocktree->ReadRCTOutput(nTestExists, ao) || ao.outpoint != op) {
+            if (!prctviewTip->ReadRCTOutput(nTestExists, ao) || ao.outpoint != op) {
                 return state.DoS(100, error("%s: Duplicate anon-output %s, index %d - existing: %s,%d.", __func__,
                         HexStr(txout->pk.begin(), txout->pk.end()), nTestExists, ao.outpoint.hash.ToString(), ao.outpoint.n),
                                 REJECT_INVALID, "duplicate-anon-output");
@@ -269,28 +326,28 @@ bool RollBackRCTIndex(int64_t nLastValidRCTOutput, int64_t nExpectErase, std::se
     while (true) {
         nRemRCTOutput++;
 
-        if (!pblocktree->ReadRCTOutput(nRemRCTOutput, ao))
+        if (!prctviewTip->ReadRCTOutput(nRemRCTOutput, ao))
             break;
 
-        pblocktree->EraseRCTOutput(nRemRCTOutput);
-        pblocktree->EraseRCTOutputLink(ao.pubkey);
+        prctviewTip->EraseRCTOutput(nRemRCTOutput);
+        prctviewTip->EraseRCTOutputLink(ao.pubkey);
     }
 
     if (nExpectErase > nRemRCTOutput) {
         nRemRCTOutput = nExpectErase;
         while (nRemRCTOutput > nLastValidRCTOutput) {
-            if (!pblocktree->ReadRCTOutput(nRemRCTOutput, ao))
+            if (!prctviewTip->ReadRCTOutput(nRemRCTOutput, ao))
                 break;
 
-            pblocktree->EraseRCTOutput(nRemRCTOutput);
-            pblocktree->EraseRCTOutputLink(ao.pubkey);
+            prctviewTip->EraseRCTOutput(nRemRCTOutput);
+            prctviewTip->EraseRCTOutputLink(ao.pubkey);
             nRemRCTOutput--;
         }
 
     }
 
     for (const auto &ki : setKi) {
-        pblocktree->EraseRCTKeyImage(ki);
+        prctviewTip->EraseRCTKeyImage(ki);
     }
 
     return true;
@@ -342,7 +399,7 @@ std::vector<COutPoint> GetRingCtInputs(const CTxIn& txin)
             ofs += nB;
 
             CAnonOutput ao;
-            if (!pblocktree->ReadRCTOutput(nIndex, ao)) {
+            if (!prctviewTip->ReadRCTOutput(nIndex, ao)) {
                 continue;
             }
             vInputs.emplace_back(ao.outpoint);
@@ -386,7 +443,7 @@ bool GetRingCtInputs(const CTxIn& txin, std::vector<std::vector<COutPoint> >& vI
             ofs += nB;
 
             CAnonOutput ao;
-            if (!pblocktree->ReadRCTOutput(nIndex, ao)) {
+            if (!prctviewTip->ReadRCTOutput(nIndex, ao)) {
                 return false;
             }
             vOutpoints.emplace_back(ao.outpoint);
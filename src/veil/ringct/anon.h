@@ -5,6 +5,8 @@
 #define VEIL_ANON_H
 
 #include <inttypes.h>
+#include <string>
+#include <vector>
 #include <primitives/transaction.h>
 
 class CTxMemPool;
@@ -18,6 +20,48 @@ const size_t MAX_ANON_INPUTS = 32; // To raise see MLSAG_MAX_ROWS also
 const size_t ANON_FEE_MULTIPLIER = 2;
 
 
+/**
+ * Closure representing the MLSAG verification of one anon transaction.
+ * The ring member keys and commitments are read from the RCT index when the
+ * check is built, so it can be run from a check queue thread without cs_main.
+ * Note that this stores a reference to the spending transaction.
+ */
+class CMLSAGCheck
+{
+private:
+    const CTransaction *ptxTo;
+    secp256k1_pedersen_commitment plainCommitment;
+    std::vector<std::vector<uint8_t> > vvM; // per txin, ring member pubkey matrix
+    std::vector<std::vector<secp256k1_pedersen_commitment> > vvCommitments; // per txin, ring member commitments
+    std::string strRejectReason;
+    int nError;
+
+public:
+    CMLSAGCheck(): ptxTo(nullptr), nError(0) {}
+    CMLSAGCheck(const CTransaction& txToIn, const secp256k1_pedersen_commitment& plainCommitmentIn,
+            std::vector<std::vector<uint8_t> >& vvMIn, std::vector<std::vector<secp256k1_pedersen_commitment> >& vvCommitmentsIn) :
+        ptxTo(&txToIn), plainCommitment(plainCommitmentIn), nError(0) {
+        vvM.swap(vvMIn);
+        vvCommitments.swap(vvCommitmentsIn);
+    }
+
+    bool operator()();
+
+    void swap(CMLSAGCheck &check) {
+        std::swap(ptxTo, check.ptxTo);
+        std::swap(plainCommitment, check.plainCommitment);
+        std::swap(vvM, check.vvM);
+        std::swap(vvCommitments, check.vvCommitments);
+        std::swap(strRejectReason, check.strRejectReason);
+        std::swap(nError, check.nError);
+    }
+
+    const std::string& GetRejectReason() const { return strRejectReason; }
+    int GetError() const { return nError; }
+};
+
+/** Check the anon inputs of tx against the RCT index and key images, and snapshot the ring members into check. */
+bool GetMLSAGCheck(const CTransaction &tx, CValidationState &state, CMLSAGCheck &check);
 bool VerifyMLSAG(const CTransaction &tx, CValidationState &state);
 
 bool AddKeyImagesToMempool(const CTransaction &tx, CTxMemPool &pool);
@@ -25,6 +25,8 @@
 #include <veil/invalid.h>
 #include <veil/ringct/blind.h>
 #include <veil/ringct/anon.h>
+#include <veil/ringct/decoyselector.h>
+#include <veil/ringct/stealthscan.h>
 #include <veil/zerocoin/denomination_functions.h>
 #include <veil/zerocoin/zchain.h>
 #include <wallet/deterministicmint.h>
@@ -167,6 +169,8 @@ bool AnonWallet::Initialise(CExtKey* pExtMaster)
                 return error("%s: failed to read keys from db", __func__);
             if (!LoadStealthAddresses())
                 return error("%s: failed to read stealth addresses id from db", __func__);
+            if (!LoadAnonKeyImages())
+                return error("%s: failed to load key images from db", __func__);
             if (!LoadTxRecords())
                 return error("%s: failed to load transaction records from db", __func__);
         } else {
@@ -189,6 +193,7 @@ bool AnonWallet::Initialise(CExtKey* pExtMaster)
 void AnonWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
 {
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
+    MarkDirty(outpoint.hash);
 
 //    setLockedCoins.erase(outpoint);
 
@@ -203,12 +208,71 @@ void AnonWallet::LoadToWallet(const uint256 &hash, const CTransactionRecord &rtx
 
     MapRecords_t::iterator mri = ret.first;
     rtxOrdered.insert(std::make_pair(rtx.GetTxTime(), mri));
+    MarkDirty(hash);
 
     // TODO: Spend only owned inputs?
 
     return;
 };
 
+bool AnonWallet::LoadAnonKeyImages()
+{
+    LOCK(pwalletParent->cs_wallet);
+
+    AnonWalletDB pwdb(*walletDatabase);
+    Dbc *pcursor;
+    if (!(pcursor = pwdb.GetCursor())) {
+        throw std::runtime_error(strprintf("%s: cannot create DB cursor", __func__).c_str());
+    }
+
+    CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+    CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+
+    std::string sPrefix = "aki";
+    std::string strType;
+
+    mapAnonKeyImages.clear();
+    unsigned int fFlags = DB_SET_RANGE;
+    ssKey << sPrefix;
+    while (pwdb.ReadAtCursor(pcursor, ssKey, ssValue, fFlags) == 0) {
+        fFlags = DB_NEXT;
+        ssKey >> strType;
+        if (strType != sPrefix) {
+            break;
+        }
+
+        CCmpPubKey ki;
+        ssKey >> ki;
+
+        COutPoint op;
+        ssValue >> op;
+        mapAnonKeyImages[ki] = op;
+    }
+
+    pcursor->close();
+
+    return true;
+}
+
+bool AnonWallet::GetAnonKeyImage(const CCmpPubKey &ki, COutPoint &op) const
+{
+    AssertLockHeld(pwalletParent->cs_wallet);
+    auto it = mapAnonKeyImages.find(ki);
+    if (it == mapAnonKeyImages.end())
+        return false;
+    op = it->second;
+    return true;
+}
+
+bool AnonWallet::WriteAnonKeyImage(AnonWalletDB *pwdb, const CCmpPubKey &ki, const COutPoint &op)
+{
+    AssertLockHeld(pwalletParent->cs_wallet);
+    if (!pwdb->WriteAnonKeyImage(ki, op))
+        return false;
+    mapAnonKeyImages[ki] = op;
+    return true;
+}
+
 bool AnonWallet::LoadTxRecords()
 {
     LOCK(pwalletParent->cs_wallet);
@@ -259,8 +323,7 @@ bool AnonWallet::LoadTxRecords()
                     *(ki.ncbegin()+32) = prevout.n;
 
                     COutPoint kiPrevout;
-                    // TODO: Keep keyimages in memory
-                    if (!pwdb.ReadAnonKeyImage(ki, kiPrevout)) {
+                    if (!GetAnonKeyImage(ki, kiPrevout)) {
                         continue;
                     }
                     AddToSpends(kiPrevout, txhash);
@@ -719,8 +782,7 @@ CAmount AnonWallet::GetDebit(AnonWalletDB *pwdb, const CTransactionRecord &rtx,
             memcpy(ki.ncbegin(), prevout.hash.begin(), 32);
             *(ki.ncbegin()+32) = prevout.n;
 
-            // TODO: Keep keyimages in memory
-            if (!pwdb->ReadAnonKeyImage(ki, kiPrevout))
+            if (!GetAnonKeyImage(ki, kiPrevout))
                 continue;
             pPrevout = &kiPrevout;
         };
@@ -969,15 +1031,188 @@ bool AnonWallet::IsTrusted(const uint256 &txhash, const uint256 &blockhash, int
 }
 
 
-CAmount AnonWallet::GetBalance(const isminefilter& filter, const int min_depth) const
+void AnonBalanceAmounts::Add(const AnonBalanceAmounts &a)
 {
-    CAmount nBalance = 0;
+    nStandardOwned += a.nStandardOwned;
+    nStandardWatch += a.nStandardWatch;
+    nStandardBoth += a.nStandardBoth;
+    nStandardAny += a.nStandardAny;
+    nBlind += a.nBlind;
+    nAnon += a.nAnon;
+    nCT += a.nCT;
+    nRingCT += a.nRingCT;
+}
+
+void AnonBalanceAmounts::Subtract(const AnonBalanceAmounts &a)
+{
+    nStandardOwned -= a.nStandardOwned;
+    nStandardWatch -= a.nStandardWatch;
+    nStandardBoth -= a.nStandardBoth;
+    nStandardAny -= a.nStandardAny;
+    nBlind -= a.nBlind;
+    nAnon -= a.nAnon;
+    nCT -= a.nCT;
+    nRingCT -= a.nRingCT;
+}
+
+CAmount AnonBalanceAmounts::GetStandard(const isminefilter &filter) const
+{
+    CAmount nAmount = 0;
+    if (filter & ISMINE_SPENDABLE)
+        nAmount += nStandardOwned;
+    if (filter & ISMINE_WATCH_ONLY)
+        nAmount += nStandardWatch;
+    if (filter & (ISMINE_SPENDABLE | ISMINE_WATCH_ONLY))
+        nAmount += nStandardBoth;
+    return nAmount;
+}
+
+void AnonWallet::GetRecordBalance(const uint256 &txhash, const CTransactionRecord &rtx, AnonBalanceAmounts &amounts) const
+{
+    // Only called for records in a main chain block. These are trusted, except that standard outputs
+    // of conflicted records (nIndex == -1) are not counted.
+    for (const auto &r : rtx.vout) {
+        if (IsSpent(txhash, r.n))
+            continue;
+
+        switch (r.nType) {
+            case OUTPUT_STANDARD:
+                if (rtx.nIndex == -1)
+                    break;
+                if (r.nFlags)
+                    amounts.nStandardAny += r.GetAmount();
+                if ((r.nFlags & ORF_OWNED) && (r.nFlags & ORF_OWN_WATCH))
+                    amounts.nStandardBoth += r.GetAmount();
+                else if (r.nFlags & ORF_OWNED)
+                    amounts.nStandardOwned += r.GetAmount();
+                else if (r.nFlags & ORF_OWN_WATCH)
+                    amounts.nStandardWatch += r.GetAmount();
+                break;
+            case OUTPUT_CT:
+                if (!(r.nFlags & ORF_OWNED))
+                    break;
+                amounts.nBlind += r.GetAmount();
+                if (!r.IsSpent())
+                    amounts.nCT += r.GetAmount();
+                break;
+            case OUTPUT_RINGCT:
+                if (!(r.nFlags & ORF_OWNED))
+                    break;
+                amounts.nAnon += r.GetAmount();
+                if (!r.IsSpent())
+                    amounts.nRingCT += r.GetAmount();
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void AnonWallet::AddToLedger(const uint256 &txhash, const CTransactionRecord &rtx) const
+{
+    int nDepth = GetDepthInMainChain(rtx.blockHash, 0);
+    if (nDepth < 1) {
+        setLedgerUnconfirmed.insert(txhash);
+        mapLedgerRecords[txhash] = std::make_pair(-1, AnonBalanceAmounts());
+        return;
+    }
+
+    AnonBalanceAmounts amounts;
+    GetRecordBalance(txhash, rtx, amounts);
+    int nHeight = chainActive.Height() - nDepth + 1;
+    mapLedgerHeights[nHeight].Add(amounts);
+    ledgerTotal.Add(amounts);
+    mapLedgerRecords[txhash] = std::make_pair(nHeight, amounts);
+}
+
+void AnonWallet::RemoveFromLedger(const uint256 &txhash) const
+{
+    auto it = mapLedgerRecords.find(txhash);
+    if (it == mapLedgerRecords.end())
+        return;
+
+    const int nHeight = it->second.first;
+    if (nHeight < 0) {
+        setLedgerUnconfirmed.erase(txhash);
+    } else {
+        mapLedgerHeights[nHeight].Subtract(it->second.second);
+        ledgerTotal.Subtract(it->second.second);
+    }
+    mapLedgerRecords.erase(it);
+}
+
+void AnonWallet::UpdateBalanceLedger() const
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(pwalletParent->cs_wallet);
+
+    if (fLedgerValid && pindexLedger && chainActive.Contains(pindexLedger)) {
+        // A changed record can change whether the outputs it spends are counted as spent
+        std::set<uint256> setRecount;
+        for (const uint256 &txhash : setLedgerDirty) {
+            setRecount.insert(txhash);
+            auto mri = mapRecords.find(txhash);
+            if (mri == mapRecords.end())
+                continue;
+            for (const COutPoint &prevout : mri->second.vin) {
+                COutPoint op = prevout;
+                if (mri->second.nFlags & ORF_ANON_IN) {
+                    CCmpPubKey ki;
+                    memcpy(ki.ncbegin(), prevout.hash.begin(), 32);
+                    *(ki.ncbegin()+32) = prevout.n;
+                    if (!GetAnonKeyImage(ki, op))
+                        continue;
+                }
+                setRecount.insert(op.hash);
+            }
+        }
+
+        for (const uint256 &txhash : setRecount) {
+            RemoveFromLedger(txhash);
+            auto mri = mapRecords.find(txhash);
+            if (mri != mapRecords.end())
+                AddToLedger(txhash, mri->second);
+        }
+    } else {
+        mapLedgerHeights.clear();
+        ledgerTotal = AnonBalanceAmounts();
+        setLedgerUnconfirmed.clear();
+        mapLedgerRecords.clear();
+
+        for (const auto &ri : mapRecords)
+            AddToLedger(ri.first, ri.second);
+    }
+    setLedgerDirty.clear();
+    // Every record in the ledger is in a block up to the tip, so the ledger is valid while the tip stays in the chain
+    pindexLedger = chainActive.Tip();
+
+    if (!MoneyRange(ledgerTotal.nStandardAny) || !MoneyRange(ledgerTotal.nBlind) || !MoneyRange(ledgerTotal.nAnon))
+        throw std::runtime_error(std::string(__func__) + ": value out of range");
 
+    fLedgerValid = true;
+}
+
+AnonBalanceAmounts AnonWallet::GetLedgerBalance(int min_depth) const
+{
+    // Depth of a block at nHeight is chainActive.Height() - nHeight + 1
+    const int nMaxHeight = chainActive.Height() - min_depth + 1;
+
+    AnonBalanceAmounts amounts = ledgerTotal;
+    for (auto it = mapLedgerHeights.rbegin(); it != mapLedgerHeights.rend() && it->first > nMaxHeight; ++it)
+        amounts.Subtract(it->second);
+
+    return amounts;
+}
+
+CAmount AnonWallet::GetBalance(const isminefilter& filter, const int min_depth) const
+{
     LOCK2(cs_main, pwalletParent->cs_wallet);
+    UpdateBalanceLedger();
 
-    for (const auto &ri : mapRecords) {
-        const uint256 &txhash = ri.first;
-        const CTransactionRecord &rtx = ri.second;
+    CAmount nBalance = GetLedgerBalance(min_depth).GetStandard(filter);
+
+    for (const uint256 &txhash : setLedgerUnconfirmed) {
+        const CTransactionRecord &rtx = mapRecords.at(txhash);
         if (!IsTrusted(txhash, rtx.blockHash, rtx.nIndex) || GetDepthInMainChain(rtx.blockHash, rtx.nIndex) < min_depth)
             continue;
 
@@ -985,7 +1220,7 @@ CAmount AnonWallet::GetBalance(const isminefilter& filter, const int min_depth)
             if (r.nType == OUTPUT_STANDARD && (((filter & ISMINE_SPENDABLE) && (r.nFlags & ORF_OWNED))
                     || ((filter & ISMINE_WATCH_ONLY) && (r.nFlags & ORF_OWN_WATCH))) && !IsSpent(txhash, r.n)) {
                 nBalance += r.GetAmount();
-	    }
+            }
         }
 
         if (!MoneyRange(nBalance))
@@ -998,22 +1233,19 @@ CAmount AnonWallet::GetBalance(const isminefilter& filter, const int min_depth)
 CAmount AnonWallet::GetSpendableBalance() const
 {
     // Returns a value to be compared against reservebalance, includes stakeable watch-only balance.
-    if (m_have_spendable_balance_cached)
-        return m_spendable_balance_cached;
-
-    CAmount nBalance = 0;
-
     LOCK2(cs_main, pwalletParent->cs_wallet);
+    UpdateBalanceLedger();
+
+    CAmount nBalance = ledgerTotal.nStandardAny;
 
-    for (const auto &ri : mapRecords) {
-        const auto &txhash = ri.first;
-        const auto &rtx = ri.second;
+    for (const uint256 &txhash : setLedgerUnconfirmed) {
+        const auto &rtx = mapRecords.at(txhash);
         if (!IsTrusted(txhash, rtx.blockHash, rtx.nIndex)) {
             continue;
         }
 
         for (const auto &r : rtx.vout) {
-            if (r.nType == OUTPUT_STANDARD && (r.nFlags & ORF_OWNED || r.nFlags) && !IsSpent(txhash, r.n))
+            if (r.nType == OUTPUT_STANDARD && r.nFlags && !IsSpent(txhash, r.n))
                 nBalance += r.GetAmount();
         }
 
@@ -1022,10 +1254,7 @@ CAmount AnonWallet::GetSpendableBalance() const
         }
     }
 
-    m_spendable_balance_cached = nBalance;
-    m_have_spendable_balance_cached = true;
-
-    return m_spendable_balance_cached;
+    return nBalance;
 };
 
 CAmount AnonWallet::GetUnconfirmedBalance() const
@@ -1033,11 +1262,12 @@ CAmount AnonWallet::GetUnconfirmedBalance() const
     CAmount nBalance = 0;
 
     LOCK2(cs_main, pwalletParent->cs_wallet);
+    UpdateBalanceLedger();
 
-    for (const auto &ri : mapRecords)
+    // Records in the ledger are confirmed, so trusted
+    for (const uint256 &txhash : setLedgerUnconfirmed)
     {
-        const auto &txhash = ri.first;
-        const auto &rtx = ri.second;
+        const auto &rtx = mapRecords.at(txhash);
 
         if (IsTrusted(txhash, rtx.blockHash))
             continue;
@@ -1061,14 +1291,14 @@ CAmount AnonWallet::GetUnconfirmedBalance() const
 
 CAmount AnonWallet::GetBlindBalance(const int min_depth)
 {
-    CAmount nBalance = 0;
-
     LOCK2(cs_main, pwalletParent->cs_wallet);
+    UpdateBalanceLedger();
 
-    for (const auto &ri : mapRecords)
+    CAmount nBalance = GetLedgerBalance(min_depth).nBlind;
+
+    for (const uint256 &txhash : setLedgerUnconfirmed)
     {
-        const auto &txhash = ri.first;
-        const auto &rtx = ri.second;
+        const auto &rtx = mapRecords.at(txhash);
         int nDepth = GetDepthInMainChain(rtx.blockHash, 0);
 
         if (!IsTrusted(txhash, rtx.blockHash))
@@ -1092,13 +1322,14 @@ CAmount AnonWallet::GetBlindBalance(const int min_depth)
 
 CAmount AnonWallet::GetAnonBalance(const int min_depth)
 {
-    CAmount nBalance = 0;
-
     LOCK2(cs_main, pwalletParent->cs_wallet);
-    for (const auto &ri : mapRecords)
+    UpdateBalanceLedger();
+
+    CAmount nBalance = GetLedgerBalance(min_depth).nAnon;
+
+    for (const uint256 &txhash : setLedgerUnconfirmed)
     {
-        const auto &txhash = ri.first;
-        const auto &rtx = ri.second;
+        const auto &rtx = mapRecords.at(txhash);
         int nDepth = GetDepthInMainChain(rtx.blockHash, 0);
 
         if (!IsTrusted(txhash, rtx.blockHash))
@@ -1125,10 +1356,19 @@ bool AnonWallet::GetBalances(BalanceList &bal)
 {
     assert(pwalletParent);
     LOCK2(cs_main, pwalletParent->cs_wallet);
+    UpdateBalanceLedger();
 
-    for (const auto &ri : mapRecords) {
-        const auto &txhash = ri.first;
-        const auto &rtx = ri.second;
+    // Records with more than 11 confirmations are confirmed, the rest of the ledger is immature
+    AnonBalanceAmounts confirmed = GetLedgerBalance(12);
+    AnonBalanceAmounts immature = ledgerTotal;
+    immature.Subtract(confirmed);
+    bal.nRingCT += confirmed.nRingCT;
+    bal.nRingCTImmature += immature.nRingCT;
+    bal.nCT += confirmed.nCT;
+    bal.nCTImmature += immature.nCT;
+
+    for (const uint256 &txhash : setLedgerUnconfirmed) {
+        const auto &rtx = mapRecords.at(txhash);
 
         bool fTrusted = IsTrusted(txhash, rtx.blockHash);
         int nDepth = GetDepthInMainChain(rtx.blockHash, 0);
@@ -1859,6 +2099,7 @@ bool AnonWallet::SaveRecord(const uint256& txid, const CTransactionRecord& rtx)
     if (!wdb.WriteTxRecord(txid, rtx))
         return error("%s: failed to write tx record\n", __func__);
     mapRecords[txid] = rtx;
+    MarkDirty(txid);
     return true;
 }
 
@@ -2956,7 +3197,7 @@ bool AnonWallet::PlaceRealOutputs(std::vector<std::vector<int64_t> > &vMI, size_
                 }
 
                 int64_t index;
-                if (!pblocktree->ReadRCTOutputLink(pk, index)) {
+                if (!prctviewTip->ReadRCTOutputLink(pk, index)) {
                     sError = strprintf("RingCT public key not found in database: %s", HexStr(pk.begin(), pk.end()));
                     return error("%s: %s", __func__, sError);
                 }
@@ -3001,6 +3242,14 @@ bool AnonWallet::PickHidingOutputs(std::vector<std::vector<int64_t> > &vMI, size
 
     int nExtraDepth = gArgs.GetBoolArg("-regtest", false) ? -1 : 2; // if not on regtest pick outputs deeper than consensus checks to prevent banning
 
+    // Outputs are indexed in chain order, so the ones deep enough are those up to the last output of the deepest allowed block
+    int nMaxDecoyHeight = std::min(nBestHeight, nBestHeight - (consensusParams.nMinRCTOutputDepth + nExtraDepth));
+    int64_t nMaxDecoyIndex = nMaxDecoyHeight < 0 ? 0 : chainActive[nMaxDecoyHeight]->nAnonOutputs;
+
+    // Usually only the blocks connected since the last call, the history is read in the background at startup
+    if (!veil::decoySelector.Sync(sError))
+        return error("%s: %s", __func__, sError);
+
     // Must add real outputs to setHave before adding the decoys.
     for (size_t k = 0; k < nInputs; ++k)
     for (size_t i = 0; i < nRingSize; ++i) {
@@ -3015,44 +3264,18 @@ bool AnonWallet::PickHidingOutputs(std::vector<std::vector<int64_t> > &vMI, size
             nMinIndex = std::max((int64_t)1, nLastRCTOutIndex - nRCTOutSelectionGroup2);
         }
 
-        int64_t nLastDepthCheckPassed = 0;
+        if (veil::decoySelector.Count(nMinIndex, nMaxDecoyIndex) == 0) {
+            sError = strprintf("Not enough anonymous outputs exist, min: %d, last: %d, required: %d.",
+                               nMinIndex, nMaxDecoyIndex, nInputs * nRingSize);
+            return error("%s: %s", __func__, sError);
+        }
+
         size_t j = 0;
         const static size_t nMaxTries = 1000;
         for (j = 0; j < nMaxTries; ++j) {
-            if (nLastRCTOutIndex <= nMinIndex) {
-                sError = strprintf("Not enough anonymous outputs exist, min: last: %d, required: %d.",
-                                   nMinIndex, nLastRCTOutIndex, nInputs * nRingSize);
-                return error("%s: %s", __func__, sError);
-            }
-
-            int64_t nDecoy = nMinIndex + GetRand((nLastRCTOutIndex - nMinIndex) + 1);
-
+            int64_t nDecoy = veil::decoySelector.Pick(nMinIndex, nMaxDecoyIndex);
             if (setHave.count(nDecoy) > 0) {
-                if (nDecoy == nLastRCTOutIndex) {
-                    nLastRCTOutIndex--;
-                }
-                continue;
-            }
-
-            CAnonOutput ao;
-            if (!pblocktree->ReadRCTOutput(nDecoy, ao)) {
-                sError = strprintf("Anonymous output not found in database: %s.", nDecoy);
-                return error("%s: %s", __func__, sError);
-            }
-
-            //Don't mix in blacklisted decoys
-            if (blacklist::ContainsRingCtOutPoint(ao.outpoint))
                 continue;
-
-            if (nDecoy > nLastDepthCheckPassed) {
-                if (ao.nBlockHeight > nBestHeight - (consensusParams.nMinRCTOutputDepth + nExtraDepth)) {
-                    if (nLastRCTOutIndex > nDecoy) {
-                        nLastRCTOutIndex = nDecoy-1;
-                    }
-                    continue;
-                }
-
-                nLastDepthCheckPassed = nDecoy;
             }
 
             vMI[k][i] = nDecoy;
@@ -3075,28 +3298,36 @@ bool AnonWallet::IsMyAnonInput(const CTxIn& txin, COutPoint& myOutpoint)
     uint32_t nInputs, nRingSize;
     txin.GetAnonInfo(nInputs, nRingSize);
 
-    size_t nCols = nRingSize;
-    size_t nRows = nInputs + 1;
-
     if (txin.scriptData.stack.size() != 1)
         return false;
 
     if (txin.scriptWitness.stack.size() != 2)
         return false;
 
-    const std::vector<uint8_t> vKeyImages = txin.scriptData.stack[0];
-    const std::vector<uint8_t> vMI = txin.scriptWitness.stack[0];
-    const std::vector<uint8_t> vDL = txin.scriptWitness.stack[1];
+    size_t nCols = nRingSize;
 
+    const std::vector<uint8_t> &vKeyImages = txin.scriptData.stack[0];
+    const std::vector<uint8_t> &vMI = txin.scriptWitness.stack[0];
     if (vKeyImages.size() != nInputs * 33)
         return false;
 
-    std::vector<uint8_t> vM(nCols * nRows * 33);
-    std::set<CKey> setKeyCandidates;
+    // The key images of owned outputs are computed when they are added to the wallet, so the ring
+    // members usually don't need to be looked up
+    LOCK(pwalletParent->cs_wallet);
+    for (size_t k = 0; k < nInputs; ++k) {
+        const CCmpPubKey &ki = *((CCmpPubKey*)&vKeyImages[k*33]);
+        if (GetAnonKeyImage(ki, myOutpoint))
+            return true;
+    }
+
+    // Outputs that were received while the wallet was locked have no key image yet, recompute it from
+    // the ring members and store it for the next lookup. That needs the keys, so it can't be done while locked.
+    if (IsLocked())
+        return false;
 
     size_t ofs = 0, nB = 0;
     for (size_t k = 0; k < nInputs; ++k) {
-        auto image = *((CCmpPubKey*)&vKeyImages[k*33]);
+        const CCmpPubKey &image = *((CCmpPubKey*)&vKeyImages[k*33]);
         for (size_t i = 0; i < nCols; ++i) {
             int64_t nIndex = 0;
 
@@ -3105,21 +3336,23 @@ bool AnonWallet::IsMyAnonInput(const CTxIn& txin, COutPoint& myOutpoint)
             ofs += nB;
 
             CAnonOutput ao;
-            if (!pblocktree->ReadRCTOutput(nIndex, ao))
+            if (!prctviewTip->ReadRCTOutput(nIndex, ao))
                 return false;
 
             CKeyID stealthDest = ao.pubkey.GetID();
             CKey key;
             if (GetKey(stealthDest, key)) {
-                std::vector<uint8_t> vchKeyImage(33);
-                if (0 != secp256k1_get_keyimage(secp256k1_ctx_blind, vchKeyImage.data(), ao.pubkey.begin(), key.begin()))
+                CCmpPubKey ki;
+                if (0 != secp256k1_get_keyimage(secp256k1_ctx_blind, ki.ncbegin(), ao.pubkey.begin(), key.begin()))
                     continue;
 
-                if (vchKeyImage == image) {
+                if (ki == image) {
                     myOutpoint = ao.outpoint;
+                    AnonWalletDB wdb(*walletDatabase);
+                    if (!WriteAnonKeyImage(&wdb, ki, myOutpoint))
+                        LogPrintf("Error: %s - WriteAnonKeyImage failed.\n", __func__);
                     return true;
                 }
-
             }
         }
     }
@@ -3542,7 +3775,7 @@ bool AnonWallet::AddAnonInputs_Inner(CWalletTx &wtx, CTransactionRecord &rtx, st
                     int64_t nIndex = vMI[l][k][i];
 
                     CAnonOutput anonOutput;
-                    if (!pblocktree->ReadRCTOutput(nIndex, anonOutput)) {
+                    if (!prctviewTip->ReadRCTOutput(nIndex, anonOutput)) {
                         sError = strprintf("Output %d not found in database.", nIndex);
                         return error("%s: %s", __func__, sError);
                     }
@@ -3564,11 +3797,10 @@ bool AnonWallet::AddAnonInputs_Inner(CWalletTx &wtx, CTransactionRecord &rtx, st
                     // Double check key image is not used... todo, this should not be done here and is result of bad state
                     uint256 txhashKI;
                     auto ki = *((CCmpPubKey*)&vKeyImages[k*33]);
-                    if (pblocktree->ReadRCTKeyImage(ki, txhashKI)) {
-                        AnonWalletDB wdb(*walletDatabase);
+                    if (prctviewTip->ReadRCTKeyImage(ki, txhashKI)) {
                         COutPoint out;
                         bool fErased = false;
-                        if (wdb.ReadAnonKeyImage(ki, out)) {
+                        if (GetAnonKeyImage(ki, out)) {
                             MarkOutputSpent(out, true);
                             fErased = true;
                         }
@@ -3607,7 +3839,7 @@ bool AnonWallet::AddAnonInputs_Inner(CWalletTx &wtx, CTransactionRecord &rtx, st
                         int64_t nIndex = vMI[l][k][i];
 
                         CAnonOutput ao;
-                        if (!pblocktree->ReadRCTOutput(nIndex, ao)) {
+                        if (!prctviewTip->ReadRCTOutput(nIndex, ao)) {
                             sError = strprintf("Output %d not found in database.", nIndex);
                             return error("%s: %s", __func__, sError);
                         }
@@ -4415,6 +4647,7 @@ bool AnonWallet::ProcessLockedBlindedOutputs()
             continue;
         }
         CTransactionRecord &rtx = mir->second;
+        MarkDirty(op.hash);
 
         if (stx.tx->vpout.size() < op.n) {
             LogPrintf("%s: Error: Outpoint doesn't exist %s.\n", __func__, op.ToString());
@@ -4485,20 +4718,6 @@ bool AnonWallet::ProcessLockedBlindedOutputs()
     return true;
 }
 
-inline bool MatchPrefix(uint32_t nAddrBits, uint32_t addrPrefix, uint32_t outputPrefix, bool fHavePrefix)
-{
-    if (nAddrBits < 1) { // addresses without prefixes scan all incoming stealth outputs
-        return true;
-    }
-    if (!fHavePrefix) { // don't check when address has a prefix and no prefix on output
-        return false;
-    }
-
-    uint32_t mask = SetStealthMask(nAddrBits);
-
-    return (addrPrefix & mask) == (outputPrefix & mask);
-}
-
 //Veil
 bool AnonWallet::AddStealthDestination(const CKeyID& idStealthAddress, const CKeyID& idStealthDestination)
 {
@@ -4555,11 +4774,19 @@ bool AnonWallet::ProcessStealthOutput(const CTxDestination &address, std::vector
         return true;
     }
 
+    // Addresses checked by PrescanStealthOutputs only need to be tried again if they matched
+    auto itPrescan = mapStealthPrescan.find(idStealthDestination);
+
     // Iterate through owned stealth addresses to see if this was sent to one of them (note: the address sent to is
     // extracted from the stealth address in a deterministic way, so the owned addresses are calculate the changes to
     // see if there is a match, if so the key belongs to us
     for (auto mi = mapStealthAddresses.begin(); mi != mapStealthAddresses.end(); ++mi) {
         auto* addr = &mi->second;
+        if (itPrescan != mapStealthPrescan.end() && itPrescan->second != mi->first
+            && setStealthPrescanAddresses.count(mi->first)) {
+            continue;
+        }
+
         if (!MatchPrefix(addr->prefix.number_bits, addr->prefix.bitfield, prefix, fHavePrefix)) {
             continue;
         }
@@ -4631,6 +4858,65 @@ bool AnonWallet::ProcessStealthOutput(const CTxDestination &address, std::vector
     return false;
 }
 
+void AnonWallet::PrescanStealthOutputs(const std::vector<CTransactionRef> &vtx)
+{
+    std::vector<CStealthScanOutput> vOutputs;
+    for (const auto &tx : vtx) {
+        if (!tx->HasBlindedValues())
+            continue;
+        for (const auto &txout : tx->vpout) {
+            CStealthScanOutput out;
+            if (GetStealthScanOutput(txout.get(), out))
+                vOutputs.emplace_back(out);
+        }
+    }
+    if (vOutputs.empty())
+        return;
+
+    std::vector<CStealthScanKey> vKeys;
+    {
+        LOCK(pwalletParent->cs_wallet);
+        ClearStealthPrescan();
+
+        // Destinations that are already linked to an address don't need the ECDH
+        vOutputs.erase(std::remove_if(vOutputs.begin(), vOutputs.end(), [this](const CStealthScanOutput &out) {
+            return mapStealthDestinations.count(out.idDestination) > 0;
+        }), vOutputs.end());
+
+        for (const auto &mi : mapStealthAddresses) {
+            const CStealthAddress &sx = mi.second;
+            if (!sx.scan_secret.IsValid())
+                continue;
+
+            CStealthScanKey key;
+            key.idAddress = mi.first;
+            key.scan_secret = sx.scan_secret;
+            key.scan_pubkey = sx.scan_pubkey;
+            key.spend_pubkey = sx.spend_pubkey;
+            key.prefix = sx.prefix;
+            vKeys.emplace_back(key);
+        }
+    }
+    if (vOutputs.empty() || vKeys.empty())
+        return;
+
+    std::vector<int> vMatches;
+    ScanStealthOutputs(vKeys, vOutputs, vMatches, GetNumCores());
+
+    LOCK(pwalletParent->cs_wallet);
+    for (size_t i = 0; i < vOutputs.size(); i++)
+        mapStealthPrescan[vOutputs[i].idDestination] = vMatches[i] < 0 ? CKeyID() : vKeys[vMatches[i]].idAddress;
+    for (const CStealthScanKey &key : vKeys)
+        setStealthPrescanAddresses.emplace(key.idAddress);
+}
+
+void AnonWallet::ClearStealthPrescan()
+{
+    LOCK(pwalletParent->cs_wallet);
+    mapStealthPrescan.clear();
+    setStealthPrescanAddresses.clear();
+}
+
 int AnonWallet::CheckForStealthAndNarration(const CTxOutBase *pb, const CTxOutData *pdata, std::string &sNarr)
 {
     // returns: -1 error, 0 nothing found, 1 narration, 2 stealth
@@ -4861,6 +5147,8 @@ void AnonWallet::RescanWallet()
     CCoinsViewMemPool viewMemPool(pcoinsTip.get(), mempool);
     view.SetBackend(viewMemPool);
 
+    MarkDirty();
+
     std::set<uint256> setErase;
     for (auto mi = mapRecords.begin(); mi != mapRecords.end(); mi++) {
         uint256 txid = mi->first;
@@ -5005,9 +5293,9 @@ void AnonWallet::RescanWallet()
                             if (secp256k1_get_keyimage(secp256k1_ctx_blind, ki.ncbegin(), txout->pk.begin(), key.begin()) == 0) {
                                 // Double check key image is not used...
                                 uint256 txhashKI;
-                                if (pblocktree->ReadRCTKeyImage(ki, txhashKI)) {
+                                if (prctviewTip->ReadRCTKeyImage(ki, txhashKI)) {
                                     COutPoint out;
-                                    if (wdb.ReadAnonKeyImage(ki, out)) {
+                                    if (GetAnonKeyImage(ki, out)) {
                                         MarkOutputSpent(out, true);
                                         LogPrintf("%s: marking ringct output %s:%d spent\n", __func__, txid.GetHex(), it->n);
                                     }
@@ -5046,7 +5334,6 @@ bool AnonWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, const CBlo
             if (txin.IsAnonInput()) {
                 nRingCT++;
 
-                AnonWalletDB wdb(*walletDatabase, "r");
                 uint32_t nInputs, nRingSize;
                 txin.GetAnonInfo(nInputs, nRingSize);
 
@@ -5060,8 +5347,7 @@ bool AnonWallet::AddToWalletIfInvolvingMe(const CTransactionRef& ptx, const CBlo
                     const CCmpPubKey &ki = *((CCmpPubKey*)&vKeyImages[k*33]);
                     COutPoint prevout;
 
-                    // TODO: Keep keyimages in memory
-                    if (!wdb.ReadAnonKeyImage(ki, prevout))
+                    if (!GetAnonKeyImage(ki, prevout))
                         continue;
 
                     MarkOutputSpent(prevout, true);
@@ -5357,7 +5643,7 @@ int AnonWallet::OwnAnonOut(AnonWalletDB *pwdb, const uint256 &txhash, const CTxO
     if (0 != secp256k1_get_keyimage(secp256k1_ctx_blind, ki.ncbegin(), pout->pk.begin(), key.begin())) {
         LogPrintf("Error: %s - secp256k1_get_keyimage failed.\n", __func__);
     } else
-    if (!pwdb->WriteAnonKeyImage(ki, op)) {
+    if (!WriteAnonKeyImage(pwdb, ki, op)) {
         LogPrintf("Error: %s - WriteAnonKeyImage failed.\n", __func__);
     }
 
@@ -5372,7 +5658,6 @@ bool AnonWallet::AddTxinToSpends(const CTxIn &txin, const uint256 &txhash)
 {
     AssertLockHeld(pwalletParent->cs_wallet);
     if (txin.IsAnonInput()) {
-        AnonWalletDB wdb(*walletDatabase, "r");
         uint32_t nInputs, nRingSize;
         txin.GetAnonInfo(nInputs, nRingSize);
 
@@ -5384,8 +5669,7 @@ bool AnonWallet::AddTxinToSpends(const CTxIn &txin, const uint256 &txhash)
         for (size_t k = 0; k < nInputs; ++k) {
             const CCmpPubKey &ki = *((CCmpPubKey*)&vKeyImages[k*33]);
             COutPoint prevout;
-            // TODO: Keep keyimages in memory
-            if (!wdb.ReadAnonKeyImage(ki, prevout)) {
+            if (!GetAnonKeyImage(ki, prevout)) {
                 continue;
             }
             AddToSpends(prevout, txhash);
@@ -5620,6 +5904,8 @@ bool AnonWallet::AddToRecord(CTransactionRecord &rtxIn, const CTransaction &tx,
     }
 
     if (fInsertedNew || fUpdated) {
+        MarkDirty(txhash);
+
         // Plain to plain will always be a wtx, revisit if adding p2p to rtx
         if (!tx.GetCTFee(rtx.nFee))
             LogPrintf("%s: ERROR - GetCTFee failed %s.\n", __func__, txhash.ToString());
@@ -6266,6 +6552,7 @@ void AnonWallet::MarkConflicted(const uint256 &hashBlock, const uint256 &hashTx)
                 rtx.nIndex = -1;
                 rtx.blockHash = hashBlock;
                 walletdb.WriteTxRecord(now, rtx);
+                MarkDirty(now);
 
                 // Iterate over all its outputs, and mark transactions in the wallet that spend them conflicted too
                 TxSpends::const_iterator iter = mapTxSpends.lower_bound(COutPoint(now, 0));
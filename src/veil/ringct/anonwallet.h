@@ -15,9 +15,12 @@
 #include <veil/ringct/outputrecord.h>
 #include <veil/ringct/transactionrecord.h>
 
+#include <crypto/common.h>
 #include <key_io.h>
 #include <veil/ringct/stealth.h>
 
+#include <unordered_map>
+
 typedef std::map<CKeyID, CStealthKeyMetadata> StealthKeyMetaMap;
 typedef std::map<CKeyID, CExtKeyAccount*> ExtKeyAccountMap;
 typedef std::map<CKeyID, CStoredExtKey*> ExtKeyMap;
@@ -98,6 +101,29 @@ public:
     };
 };
 
+/** Owned, unspent output values of wallet records, split the way the balance queries need them */
+struct AnonBalanceAmounts
+{
+    CAmount nStandardOwned = 0;  // ORF_OWNED and not ORF_OWN_WATCH
+    CAmount nStandardWatch = 0;  // ORF_OWN_WATCH and not ORF_OWNED
+    CAmount nStandardBoth = 0;
+    CAmount nStandardAny = 0;    // any flags, compared against reservebalance
+    CAmount nBlind = 0;          // CT not spent by a wallet record
+    CAmount nAnon = 0;
+    CAmount nCT = 0;             // CT not spent by a wallet record and not marked spent
+    CAmount nRingCT = 0;
+
+    void Add(const AnonBalanceAmounts &a);
+    void Subtract(const AnonBalanceAmounts &a);
+    CAmount GetStandard(const isminefilter &filter) const;
+};
+
+/** Key images are points derived from secret keys, so any eight bytes of them hash well enough */
+struct KeyImageHasher
+{
+    size_t operator()(const CCmpPubKey &ki) const { return ReadLE64(ki.begin() + 1); }
+};
+
 class AnonWallet
 {
     std::shared_ptr<WalletDatabase> walletDatabase;
@@ -118,6 +144,36 @@ class AnonWallet
     typedef std::multimap<COutPoint, uint256> TxSpends;
     TxSpends mapTxSpends;
 
+    // Key images of the owned RingCT outputs, as stored in the "aki" records of AnonWalletDB. Spends of our
+    // outputs are recognised by looking up the key images of a transaction here.
+    std::unordered_map<CCmpPubKey, COutPoint, KeyImageHasher> mapAnonKeyImages;
+
+    // Set by PrescanStealthOutputs: the owned stealth address each scanned destination was sent to (null if none),
+    // and the addresses that were tried
+    std::map<CKeyID, CKeyID> mapStealthPrescan;
+    std::set<CKeyID> setStealthPrescanAddresses;
+
+    // Balance ledger: amounts of the records in main chain blocks, by block height. Depth is derived from
+    // the tip at query time, so it stays valid while the chain is extended. Records passed to
+    // MarkDirty(txhash) are taken out of the ledger and added back with their new amounts. The ledger is
+    // rebuilt after MarkDirty() or when pindexLedger leaves the main chain. Unconfirmed records are
+    // evaluated on every query.
+    mutable std::map<int, AnonBalanceAmounts> mapLedgerHeights;
+    mutable AnonBalanceAmounts ledgerTotal;
+    mutable std::set<uint256> setLedgerUnconfirmed;
+    //! The height each record is counted at (-1 if unconfirmed) and the amounts it added
+    mutable std::map<uint256, std::pair<int, AnonBalanceAmounts>> mapLedgerRecords;
+    mutable std::set<uint256> setLedgerDirty;
+    mutable const CBlockIndex *pindexLedger = nullptr;
+    mutable bool fLedgerValid = false;
+
+    void UpdateBalanceLedger() const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    void AddToLedger(const uint256 &txhash, const CTransactionRecord &rtx) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    void RemoveFromLedger(const uint256 &txhash) const;
+    void GetRecordBalance(const uint256 &txhash, const CTransactionRecord &rtx, AnonBalanceAmounts &amounts) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+    //! Ledger amounts of the records with at least min_depth confirmations
+    AnonBalanceAmounts GetLedgerBalance(int min_depth) const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
 public:
     AnonWallet(std::shared_ptr<CWallet> pwallet, std::string name, std::shared_ptr<WalletDatabase> dbw_in)
     {
@@ -204,6 +260,10 @@ public:
     CAmount GetAnonBalance(const int min_depth=0);
 
     bool GetBalances(BalanceList &bal);
+    //! Invalidate the balance ledger, call after changing many records
+    void MarkDirty() { fLedgerValid = false; }
+    //! Recount a record in the balance ledger, call after changing it or the spends of its outputs
+    void MarkDirty(const uint256 &txhash) { setLedgerDirty.insert(txhash); }
 //    CAmount GetAvailableBalance(const CCoinControl* coinControl = nullptr) const;
     CAmount GetAvailableAnonBalance(const CCoinControl* coinControl = nullptr) const;
     CAmount GetAvailableBlindBalance(const CCoinControl* coinControl = nullptr) const;
@@ -250,6 +310,11 @@ public:
 
     void LoadToWallet(const uint256 &hash, const CTransactionRecord &rtx);
     bool LoadTxRecords();
+    bool LoadAnonKeyImages();
+
+    //! Outpoint of the owned RingCT output with key image ki
+    bool GetAnonKeyImage(const CCmpPubKey &ki, COutPoint &op) const;
+    bool WriteAnonKeyImage(AnonWalletDB *pwdb, const CCmpPubKey &ki, const COutPoint &op);
 
     /** Remove txn from mapwallet and TxSpends */
     void RemoveFromTxSpends(const uint256 &hash, const CTransactionRef pt);
@@ -294,6 +359,10 @@ public:
     bool ProcessLockedBlindedOutputs();
     bool ProcessStealthOutput(const CTxDestination &address,
         std::vector<uint8_t> &vchEphemPK, uint32_t prefix, bool fHavePrefix, CKey &sShared, bool fNeedShared=false);
+    /** Match the stealth outputs of a block against the owned stealth addresses on several threads, holding cs_wallet only
+     * to read the addresses and store the results. ProcessStealthOutput then skips the addresses that did not match. */
+    void PrescanStealthOutputs(const std::vector<CTransactionRef> &vtx);
+    void ClearStealthPrescan();
 
     int CheckForStealthAndNarration(const CTxOutBase *pb, const CTxOutData *pdata, std::string &sNarr);
     bool FindStealthTransactions(const CTransaction &tx, mapValue_t &mapNarr);
@@ -350,8 +419,6 @@ public:
 
     mutable int m_greatest_txn_depth = 0; // depth of most deep txn
     //mutable int m_least_txn_depth = 0; // depth of least deep txn
-    mutable bool m_have_spendable_balance_cached = false;
-    mutable CAmount m_spendable_balance_cached = 0;
 
     mutable MapWallet_t mapTempWallet;
 
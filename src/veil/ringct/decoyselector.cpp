@@ -0,0 +1,119 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veil/ringct/decoyselector.h>
+
+#include <chain.h>
+#include <logging.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <txdb.h>
+#include <utiltime.h>
+#include <validation.h>
+#include <veil/invalid.h>
+
+#include <algorithm>
+
+namespace veil {
+
+DecoySelector decoySelector;
+
+bool DecoySelector::Add(int64_t nIndex, const COutPoint& outpoint)
+{
+    LOCK(cs);
+    if (nIndex != nLastIndex + 1)
+        return false;
+    if (!blacklist::ContainsRingCtOutPoint(outpoint))
+        vEligible.emplace_back(nIndex);
+    nLastIndex = nIndex;
+    return true;
+}
+
+void DecoySelector::Rewind(int64_t nIndex)
+{
+    LOCK(cs);
+    if (nIndex >= nLastIndex)
+        return;
+    nLastIndex = std::max(nIndex, (int64_t)0);
+    vEligible.erase(std::upper_bound(vEligible.begin(), vEligible.end(), nLastIndex), vEligible.end());
+}
+
+int64_t DecoySelector::LastIndex() const
+{
+    LOCK(cs);
+    return nLastIndex;
+}
+
+bool DecoySelector::IsSynced() const
+{
+    AssertLockHeld(cs_main);
+    LOCK(cs);
+    return pindexSynced && pindexSynced == chainActive.Tip();
+}
+
+bool DecoySelector::Sync(std::string& sError, int64_t nMaxOutputs)
+{
+    const int64_t nStart = GetTimeMillis();
+    int64_t nRead = 0;
+    while (nMaxOutputs == -1 || nRead < nMaxOutputs) {
+        LOCK2(cs_main, cs);
+        const CBlockIndex* pindexTip = chainActive.Tip();
+        if (!pindexTip) {
+            sError = "No chain tip.";
+            return false;
+        }
+
+        // Outputs past the fork point may have been replaced by the outputs of other blocks
+        if (pindexSynced && !chainActive.Contains(pindexSynced)) {
+            pindexSynced = chainActive.FindFork(pindexSynced);
+            Rewind(pindexSynced ? pindexSynced->nAnonOutputs : 0);
+        }
+        if (pindexSynced == pindexTip)
+            break;
+
+        // Whole blocks, so that the outputs always end at pindexSynced
+        const int64_t nBatchEnd = nRead + DECOY_SYNC_BATCH_OUTPUTS;
+        const CBlockIndex* pindex = pindexSynced ? chainActive.Next(pindexSynced) : chainActive.Genesis();
+        for (; pindex && nRead < nBatchEnd; pindex = chainActive.Next(pindex)) {
+            for (int64_t i = nLastIndex + 1; i <= pindex->nAnonOutputs; i++) {
+                CAnonOutput ao;
+                if (!prctviewTip->ReadRCTOutput(i, ao)) {
+                    Rewind(pindexSynced ? pindexSynced->nAnonOutputs : 0);
+                    sError = strprintf("Anonymous output not found in database: %s.", i);
+                    return false;
+                }
+                Add(i, ao.outpoint);
+                nRead++;
+            }
+            pindexSynced = pindex;
+        }
+    }
+
+    if (nRead > 0) {
+        LOCK(cs);
+        LogPrint(BCLog::RINGCT, "%s: read %d outputs up to %d in %dms, %d eligible\n", __func__, nRead, nLastIndex,
+                 GetTimeMillis() - nStart, vEligible.size());
+    }
+    return true;
+}
+
+size_t DecoySelector::Count(int64_t nMin, int64_t nMax) const
+{
+    LOCK(cs);
+    if (nMax < nMin)
+        return 0;
+    return std::upper_bound(vEligible.begin(), vEligible.end(), nMax) - std::lower_bound(vEligible.begin(), vEligible.end(), nMin);
+}
+
+int64_t DecoySelector::Pick(int64_t nMin, int64_t nMax) const
+{
+    LOCK(cs);
+    const size_t nCount = Count(nMin, nMax);
+    if (nCount == 0)
+        return -1;
+    auto it = std::lower_bound(vEligible.begin(), vEligible.end(), nMin);
+    return *(it + GetRand(nCount));
+}
+
+} // namespace veil
@@ -0,0 +1,70 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VEIL_DECOYSELECTOR_H
+#define VEIL_DECOYSELECTOR_H
+
+#include <sync.h>
+
+#include <string>
+#include <vector>
+
+class CBlockIndex;
+class COutPoint;
+
+extern CCriticalSection cs_main;
+
+namespace veil {
+
+//! Sync() reads whole blocks, and releases cs_main once it read at least this many outputs
+static const int64_t DECOY_SYNC_BATCH_OUTPUTS = 10000;
+
+/**
+ * The DecoySelector keeps the RCT output indexes of the main chain that may be mixed into a ring,
+ * so that decoys can be picked without reading the outputs from the block tree db.
+ *
+ * RCT output indexes are assigned in chain order, so the outputs deep enough to be used are the
+ * ones up to CBlockIndex::nAnonOutputs of the deepest allowed block, and only the blacklist needs
+ * to be applied to the array. Sync() reads the outputs added since the last call, or since the
+ * fork point after a reorganisation. The wallet starts it in the background at startup, so that
+ * the first transaction only has to read the blocks connected since.
+ */
+class DecoySelector
+{
+private:
+    mutable CCriticalSection cs;
+    //! Indexes of the outputs that aren't blacklisted, ascending
+    std::vector<int64_t> vEligible GUARDED_BY(cs);
+    //! Outputs up to this index have been added
+    int64_t nLastIndex GUARDED_BY(cs) = 0;
+    //! The block whose outputs were added last
+    const CBlockIndex* pindexSynced GUARDED_BY(cs) = nullptr;
+
+public:
+    //! Add the output with index LastIndex() + 1, unless it is blacklisted. Returns false for any other index.
+    bool Add(int64_t nIndex, const COutPoint& outpoint);
+    //! Drop the outputs after nIndex
+    void Rewind(int64_t nIndex);
+    int64_t LastIndex() const;
+
+    /**
+     * Bring the index up to the tip of chainActive. With nMaxOutputs != -1, return after reading at least that
+     * many outputs, the next call continues from there. cs_main is taken for each batch of
+     * DECOY_SYNC_BATCH_OUTPUTS outputs, so that a call without cs_main does not hold up validation.
+     */
+    bool Sync(std::string& sError, int64_t nMaxOutputs = -1);
+    bool IsSynced() const EXCLUSIVE_LOCKS_REQUIRED(cs_main);
+
+    //! Number of eligible outputs with nMin <= index <= nMax
+    size_t Count(int64_t nMin, int64_t nMax) const;
+    //! A uniformly picked eligible output with nMin <= index <= nMax, or -1 if there are none
+    int64_t Pick(int64_t nMin, int64_t nMax) const;
+};
+
+//! Shared by all wallets
+extern DecoySelector decoySelector;
+
+} // namespace veil
+
+#endif // VEIL_DECOYSELECTOR_H
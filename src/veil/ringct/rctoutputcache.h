@@ -0,0 +1,122 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VEIL_RCTOUTPUTCACHE_H
+#define VEIL_RCTOUTPUTCACHE_H
+
+#include <sync.h>
+#include <veil/ringct/rctindex.h>
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+//! -rctoutputcache default (MiB)
+static const int64_t DEFAULT_RCT_OUTPUT_CACHE = 32;
+
+namespace veil {
+
+/**
+ * The AnonOutputCache keeps CAnonOutput entries of the block tree db in memory,
+ * addressed by their RCT output index.
+ *
+ * RCT output indexes are assigned contiguously, so the cache is organised in pages
+ * of PAGE_SIZE consecutive indexes. A lookup is a hash of the page number followed
+ * by an array access. When the cache is full the least-recently-used page is evicted.
+ *
+ * The owner is responsible for calling Set() and Erase() whenever the underlying
+ * db entry is written or erased. Uses an internal mutex to prevent concurrent access.
+ */
+class AnonOutputCache
+{
+public:
+    static const int64_t PAGE_SIZE = 1024;
+
+private:
+    struct Page
+    {
+        std::vector<CAnonOutput> vOutputs;
+        std::vector<bool> vHave;
+        std::list<int64_t>::iterator itLRU;
+
+        Page() : vOutputs(PAGE_SIZE), vHave(PAGE_SIZE, false) {}
+    };
+
+    std::unordered_map<int64_t, Page> mapPages;
+    std::list<int64_t> lruPages;
+    size_t nMaxPages;
+    CCriticalSection cs_cache;
+
+    Page* FindPage(int64_t nPage)
+    {
+        auto it = mapPages.find(nPage);
+        if (it == mapPages.end())
+            return nullptr;
+        lruPages.splice(lruPages.begin(), lruPages, it->second.itLRU);
+        return &it->second;
+    }
+
+    Page& GetPage(int64_t nPage)
+    {
+        Page* pPage = FindPage(nPage);
+        if (pPage)
+            return *pPage;
+
+        if (mapPages.size() >= nMaxPages) {
+            mapPages.erase(lruPages.back());
+            lruPages.pop_back();
+        }
+        lruPages.push_front(nPage);
+        Page& page = mapPages[nPage];
+        page.itLRU = lruPages.begin();
+        return page;
+    }
+
+public:
+    explicit AnonOutputCache(size_t nMaxBytes) : nMaxPages(std::max((size_t)1, nMaxBytes / (PAGE_SIZE * sizeof(CAnonOutput)))) {}
+
+    bool Get(int64_t nIndex, CAnonOutput& ao)
+    {
+        if (nIndex < 0)
+            return false;
+        LOCK(cs_cache);
+        Page* pPage = FindPage(nIndex / PAGE_SIZE);
+        if (!pPage || !pPage->vHave[nIndex % PAGE_SIZE])
+            return false;
+        ao = pPage->vOutputs[nIndex % PAGE_SIZE];
+        return true;
+    }
+
+    void Set(int64_t nIndex, const CAnonOutput& ao)
+    {
+        if (nIndex < 0)
+            return;
+        LOCK(cs_cache);
+        Page& page = GetPage(nIndex / PAGE_SIZE);
+        page.vOutputs[nIndex % PAGE_SIZE] = ao;
+        page.vHave[nIndex % PAGE_SIZE] = true;
+    }
+
+    void Erase(int64_t nIndex)
+    {
+        if (nIndex < 0)
+            return;
+        LOCK(cs_cache);
+        auto it = mapPages.find(nIndex / PAGE_SIZE);
+        if (it != mapPages.end())
+            it->second.vHave[nIndex % PAGE_SIZE] = false;
+    }
+
+    void Clear()
+    {
+        LOCK(cs_cache);
+        mapPages.clear();
+        lruPages.clear();
+    }
+};
+
+} // namespace veil
+
+#endif // VEIL_RCTOUTPUTCACHE_H
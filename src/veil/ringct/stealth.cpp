@@ -505,7 +505,8 @@ void ECC_Start_Stealth()
 {
     assert(secp256k1_ctx_stealth == nullptr);
 
-    secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+    // Signing tables are needed for the shared secret times G in ScanStealthOutputs
+    secp256k1_context *ctx = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
     assert(ctx != nullptr);
 
     secp256k1_ctx_stealth = ctx;
@@ -18,8 +18,12 @@
 
 #include <veil/ringct/types.h>
 
+#include <secp256k1.h>
+
 class CScript;
 
+extern secp256k1_context *secp256k1_ctx_stealth;
+
 const uint32_t MAX_STEALTH_NARRATION_SIZE = 48;
 const uint32_t MIN_STEALTH_RAW_SIZE = 1 + 33 + 1 + 33 + 1 + 1; // without checksum (4bytes) or version (1byte)
 
@@ -0,0 +1,171 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veil/ringct/stealthscan.h>
+
+#include <crypto/sha256.h>
+#include <hash.h>
+#include <primitives/transaction.h>
+#include <script/standard.h>
+#include <support/cleanse.h>
+#include <veil/ringct/extkey.h>
+#include <veil/workerpool.h>
+
+#include <algorithm>
+#include <map>
+
+static bool GetStealthData(const std::vector<uint8_t> &vData, CStealthScanOutput &out)
+{
+    if (vData.size() != 33) {
+        if (vData.size() == 38 // Have prefix
+            && vData[33] == DO_STEALTH_PREFIX) {
+            out.fHavePrefix = true;
+            memcpy(&out.prefix, &vData[34], 4);
+        } else {
+            return false;
+        }
+    }
+
+    out.vchEphemPK.assign(vData.begin(), vData.begin() + 33);
+    return true;
+}
+
+bool GetStealthScanOutput(const CTxOutBase *txout, CStealthScanOutput &out)
+{
+    if (txout->IsType(OUTPUT_CT)) {
+        const CTxOutCT *ctout = (CTxOutCT*) txout;
+
+        CTxDestination address;
+        if (!ExtractDestination(ctout->scriptPubKey, address)
+            || address.type() != typeid(CKeyID)) {
+            return false;
+        }
+        out.idDestination = boost::get<CKeyID>(address);
+        return GetStealthData(ctout->vData, out);
+    }
+
+    if (txout->IsType(OUTPUT_RINGCT)) {
+        const CTxOutRingCT *rctout = (CTxOutRingCT*) txout;
+        out.idDestination = rctout->pk.GetID();
+        return GetStealthData(rctout->vData, out);
+    }
+
+    return false;
+}
+
+namespace {
+
+//! The owned addresses that share a scan secret. The ECDH with an output, and the shared secret times G, are
+//! computed once for all of them.
+struct CScanSecretGroup
+{
+    const CKey *pScanSecret;
+    std::vector<std::pair<int, secp256k1_pubkey>> vSpendKeys; // index in vKeys, parsed spend pubkey
+};
+
+} // namespace
+
+void ScanStealthOutputs(const std::vector<CStealthScanKey> &vKeys, const std::vector<CStealthScanOutput> &vOutputs,
+        std::vector<int> &vMatches, int nThreads)
+{
+    vMatches.assign(vOutputs.size(), -1);
+    if (vOutputs.empty() || vKeys.empty())
+        return;
+
+    // Group the keys by scan pubkey, which identifies the scan secret without keeping copies of it, and parse the
+    // spend pubkeys once rather than for every output
+    std::vector<CScanSecretGroup> vGroups;
+    std::map<ec_point, size_t> mapGroups;
+    for (size_t i = 0; i < vKeys.size(); i++) {
+        const CStealthScanKey &key = vKeys[i];
+        secp256k1_pubkey R;
+        if (key.spend_pubkey.size() != EC_COMPRESSED_SIZE
+            || !secp256k1_ec_pubkey_parse(secp256k1_ctx_stealth, &R, &key.spend_pubkey[0], EC_COMPRESSED_SIZE)) {
+            continue;
+        }
+
+        // Without a scan pubkey the key can't be matched with others, and is scanned on its own
+        size_t nGroup = vGroups.size();
+        if (key.scan_pubkey.size() == EC_COMPRESSED_SIZE)
+            nGroup = mapGroups.emplace(key.scan_pubkey, vGroups.size()).first->second;
+        if (nGroup == vGroups.size())
+            vGroups.push_back(CScanSecretGroup{&key.scan_secret, {}});
+        vGroups[nGroup].vSpendKeys.emplace_back(i, R);
+    }
+
+    // Parse each ephemeral pubkey once rather than for every key
+    std::vector<secp256k1_pubkey> vEphem(vOutputs.size());
+    std::vector<bool> vHaveEphem(vOutputs.size(), false);
+    for (size_t i = 0; i < vOutputs.size(); i++) {
+        const ec_point &pkEphem = vOutputs[i].vchEphemPK;
+        vHaveEphem[i] = pkEphem.size() == EC_COMPRESSED_SIZE
+            && secp256k1_ec_pubkey_parse(secp256k1_ctx_stealth, &vEphem[i], &pkEphem[0], EC_COMPRESSED_SIZE);
+    }
+
+    const size_t nPairs = vOutputs.size() * vGroups.size();
+    if (nPairs == 0)
+        return;
+    nThreads = std::max(1, std::min(nThreads, (int)(nPairs / STEALTH_SCAN_PAIRS_PER_THREAD)));
+
+    // Each task takes a contiguous range of (output, scan secret) pairs and collects its own (output, key) matches
+    std::vector<std::vector<std::pair<size_t, int>>> vTaskMatches(nThreads);
+    veil::workerPool.Run(nThreads, [&](size_t nTask) {
+        const size_t nBegin = nPairs * nTask / nThreads;
+        const size_t nEnd = nPairs * (nTask + 1) / nThreads;
+
+        uint8_t tmp33[33];
+        size_t len;
+        uint8_t sShared[32];
+        for (size_t p = nBegin; p < nEnd; p++) {
+            const size_t nOutput = p / vGroups.size();
+            const CStealthScanOutput &out = vOutputs[nOutput];
+            const CScanSecretGroup &group = vGroups[p % vGroups.size()];
+            if (!vHaveEphem[nOutput])
+                continue;
+
+            bool fPrefixMatch = false;
+            for (const auto &spend : group.vSpendKeys) {
+                const stealth_prefix &prefix = vKeys[spend.first].prefix;
+                fPrefixMatch |= MatchPrefix(prefix.number_bits, prefix.bitfield, out.prefix, out.fHavePrefix);
+            }
+            if (!fPrefixMatch)
+                continue;
+
+            // c = H(dP), C = cG
+            secp256k1_pubkey Q = vEphem[nOutput];
+            if (!secp256k1_ec_pubkey_tweak_mul(secp256k1_ctx_stealth, &Q, group.pScanSecret->begin()))
+                continue;
+            len = 33;
+            secp256k1_ec_pubkey_serialize(secp256k1_ctx_stealth, tmp33, &len, &Q, SECP256K1_EC_COMPRESSED);
+            CSHA256().Write(tmp33, 33).Finalize(sShared);
+
+            secp256k1_pubkey C;
+            if (!secp256k1_ec_pubkey_create(secp256k1_ctx_stealth, &C, sShared))
+                continue;
+
+            // R' = R + C for each spend key
+            for (const auto &spend : group.vSpendKeys) {
+                const stealth_prefix &prefix = vKeys[spend.first].prefix;
+                if (!MatchPrefix(prefix.number_bits, prefix.bitfield, out.prefix, out.fHavePrefix))
+                    continue;
+
+                secp256k1_pubkey Rprime;
+                const secp256k1_pubkey *vPoints[2] = {&spend.second, &C};
+                if (!secp256k1_ec_pubkey_combine(secp256k1_ctx_stealth, &Rprime, vPoints, 2))
+                    continue;
+                len = 33;
+                secp256k1_ec_pubkey_serialize(secp256k1_ctx_stealth, tmp33, &len, &Rprime, SECP256K1_EC_COMPRESSED);
+
+                if (CKeyID(Hash160(tmp33, tmp33 + 33)) == out.idDestination)
+                    vTaskMatches[nTask].emplace_back(nOutput, spend.first);
+            }
+        }
+        memory_cleanse(sShared, sizeof(sShared));
+    });
+
+    for (const auto &vTaskMatch : vTaskMatches) {
+        for (const auto &match : vTaskMatch)
+            vMatches[match.first] = match.second;
+    }
+}
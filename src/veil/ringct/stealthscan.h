@@ -0,0 +1,66 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VEIL_STEALTHSCAN_H
+#define VEIL_STEALTHSCAN_H
+
+#include <key.h>
+#include <pubkey.h>
+#include <veil/ringct/stealth.h>
+
+#include <vector>
+
+class CTxOutBase;
+
+//! Minimum number of (output, scan secret) pairs worth splitting off another stealth scan task for
+static const size_t STEALTH_SCAN_PAIRS_PER_THREAD = 16;
+
+/** An owned stealth address, with what is needed to recognise outputs sent to it */
+struct CStealthScanKey
+{
+    CKeyID idAddress;
+    CKey scan_secret;
+    ec_point scan_pubkey;   // keys with the same scan pubkey share the ECDH of an output
+    ec_point spend_pubkey;
+    stealth_prefix prefix;
+};
+
+/** The stealth data of a CT or RingCT output */
+struct CStealthScanOutput
+{
+    CKeyID idDestination;
+    ec_point vchEphemPK;
+    uint32_t prefix = 0;
+    bool fHavePrefix = false;
+};
+
+inline bool MatchPrefix(uint32_t nAddrBits, uint32_t addrPrefix, uint32_t outputPrefix, bool fHavePrefix)
+{
+    if (nAddrBits < 1) { // addresses without prefixes scan all incoming stealth outputs
+        return true;
+    }
+    if (!fHavePrefix) { // don't check when address has a prefix and no prefix on output
+        return false;
+    }
+
+    uint32_t mask = SetStealthMask(nAddrBits);
+
+    return (addrPrefix & mask) == (outputPrefix & mask);
+}
+
+//! Read the destination, ephemeral pubkey and prefix of a CT or RingCT output. Returns false for other outputs.
+bool GetStealthScanOutput(const CTxOutBase *txout, CStealthScanOutput &out);
+
+/**
+ * Find the key each output was sent to. Gives the same result as StealthSecret on every (output, key) pair
+ * with a matching prefix, but keys that share a scan pubkey do the ECDH and the multiplication by G once per
+ * output, then only need a point addition each. Pubkeys are parsed once per call. The (output, scan secret)
+ * pairs are split into up to nThreads tasks on veil::workerPool. Needs ECC_Start_Stealth().
+ *
+ * vMatches receives, for each output, the index of the matching key in vKeys or -1.
+ */
+void ScanStealthOutputs(const std::vector<CStealthScanKey> &vKeys, const std::vector<CStealthScanOutput> &vOutputs,
+        std::vector<int> &vMatches, int nThreads);
+
+#endif // VEIL_STEALTHSCAN_H
@@ -0,0 +1,109 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <veil/workerpool.h>
+
+#include <util.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+
+namespace veil {
+
+WorkerPool workerPool;
+
+struct WorkerPool::Batch
+{
+    const std::function<void(size_t)>* pfn;
+    size_t nTasks;
+    //! The next task to be started. Tasks are claimed by incrementing it, the function is only used for claimed
+    //! tasks, so a worker that gets to the batch after the caller returned doesn't touch it.
+    std::atomic<size_t> nNext{0};
+    std::atomic<size_t> nDone{0};
+
+    //! Not boost's, so that waiting for the tasks isn't an interruption point: the caller must not return while a
+    //! worker still uses the function.
+    std::mutex mutex;
+    std::condition_variable condDone;
+    std::exception_ptr exception;
+
+    Batch(const std::function<void(size_t)>* pfnIn, size_t nTasksIn) : pfn(pfnIn), nTasks(nTasksIn) {}
+};
+
+void WorkerPool::Process(Batch& batch)
+{
+    for (size_t nTask = batch.nNext++; nTask < batch.nTasks; nTask = batch.nNext++) {
+        try {
+            (*batch.pfn)(nTask);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            if (!batch.exception)
+                batch.exception = std::current_exception();
+        }
+
+        if (++batch.nDone == batch.nTasks) {
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            batch.condDone.notify_all();
+        }
+    }
+}
+
+void WorkerPool::Run(size_t nTasks, const std::function<void(size_t)>& fn)
+{
+    size_t nHelpers = std::min<size_t>(nWorkers, nTasks > 0 ? nTasks - 1 : 0);
+    if (nHelpers == 0) {
+        for (size_t nTask = 0; nTask < nTasks; nTask++)
+            fn(nTask);
+        return;
+    }
+
+    auto batch = std::make_shared<Batch>(&fn, nTasks);
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        for (size_t i = 0; i < nHelpers; i++)
+            queue.push_back(batch);
+    }
+    if (nHelpers == 1)
+        condWorker.notify_one();
+    else
+        condWorker.notify_all();
+
+    Process(*batch);
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->condDone.wait(lock, [&batch] { return batch->nDone == batch->nTasks; });
+    if (batch->exception)
+        std::rethrow_exception(batch->exception);
+}
+
+void WorkerPool::Thread()
+{
+    nWorkers++;
+    try {
+        while (true) {
+            std::shared_ptr<Batch> batch;
+            {
+                boost::unique_lock<boost::mutex> lock(mutex);
+                while (queue.empty())
+                    condWorker.wait(lock); // interruption point
+                batch = std::move(queue.front());
+                queue.pop_front();
+            }
+            Process(*batch);
+        }
+    } catch (...) {
+        nWorkers--;
+        throw;
+    }
+}
+
+void ThreadWorkerPool()
+{
+    RenameThread("veil-worker");
+    workerPool.Thread();
+}
+
+} // namespace veil
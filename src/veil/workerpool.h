@@ -0,0 +1,59 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VEIL_WORKERPOOL_H
+#define VEIL_WORKERPOOL_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace veil {
+
+/**
+ * Long-lived threads for splitting CPU heavy work that isn't part of block validation, such as stealth scanning,
+ * accumulating a batch of mints or deriving deterministic mints, into independent tasks.
+ *
+ * Unlike with a CCheckQueue, any number of threads can call Run() at the same time, and tasks may call Run()
+ * themselves. The caller takes part in running its own tasks, so Run() finishes even when all workers are busy,
+ * or when no workers were started at all.
+ */
+class WorkerPool
+{
+private:
+    struct Batch;
+
+    boost::mutex mutex;
+    //! Workers block on this while there is nothing queued
+    boost::condition_variable condWorker;
+    //! Batches that may have tasks left, once for each worker asked to help with it
+    std::deque<std::shared_ptr<Batch>> queue;
+    std::atomic<int> nWorkers{0};
+
+    static void Process(Batch& batch);
+
+public:
+    //! Run fn(0) to fn(nTasks - 1) on this thread and the workers, and return once all have finished. The first
+    //! exception thrown by a task is rethrown here, after the other tasks have finished.
+    void Run(size_t nTasks, const std::function<void(size_t)>& fn);
+
+    //! Worker thread loop, returns when the thread is interrupted
+    void Thread();
+
+    int GetWorkerCount() const { return nWorkers; }
+};
+
+//! Shared by everything that uses it, the workers are started in AppInitMain
+extern WorkerPool workerPool;
+
+/** Run an instance of the worker pool thread */
+void ThreadWorkerPool();
+
+} // namespace veil
+
+#endif // VEIL_WORKERPOOL_H
@@ -8,6 +8,8 @@
 #include "libzerocoin/Denominations.h"
 #include "validation.h"
 
+#include "veil/workerpool.h"
+
 using namespace libzerocoin;
 using namespace std;
 
@@ -75,6 +77,31 @@ bool AccumulatorMap::Accumulate(const PublicCoin& pubCoin, bool fSkipValidation)
     return mapAccumulators.at(denom)->accumulate(pubCoin);
 }
 
+//Accumulate a batch of coins, combining the values of each denomination into as few exponentiations as possible.
+//Nothing is accumulated if any of the coins is invalid.
+bool AccumulatorMap::Accumulate(const std::vector<PublicCoin>& vPubcoins, bool fSkipValidation)
+{
+    std::map<CoinDenomination, std::vector<CBigNum> > mapValues;
+    for (const PublicCoin& pubCoin : vPubcoins) {
+        CoinDenomination denom = pubCoin.getDenomination();
+        if (denom == CoinDenomination::ZQ_ERROR)
+            return false;
+        if (!fSkipValidation && !pubCoin.validate())
+            return false;
+        mapValues[denom].emplace_back(pubCoin.getValue());
+    }
+
+    //Every denomination has its own accumulator, so each is updated as a separate task on the worker pool
+    std::vector<std::pair<libzerocoin::Accumulator*, const std::vector<CBigNum>*> > vTasks;
+    for (const auto& denomValues : mapValues) {
+        setUnusedDenominations.erase(denomValues.first);
+        vTasks.emplace_back(mapAccumulators.at(denomValues.first).get(), &denomValues.second);
+    }
+    veil::workerPool.Run(vTasks.size(), [&vTasks](size_t nTask) { vTasks[nTask].first->increment(*vTasks[nTask].second); });
+
+    return true;
+}
+
 libzerocoin::Accumulator AccumulatorMap::GetAccumulator(libzerocoin::CoinDenomination denom)
 {
     return libzerocoin::Accumulator(params, denom, GetValue(denom));
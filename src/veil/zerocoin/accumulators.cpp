@@ -211,6 +211,46 @@ bool InitializeAccumulators(const int nHeight, int& nHeightCheckpoint, Accumulat
     return true;
 }
 
+// Get the pubcoins of one denomination minted in a block from the pubcoin index. Fails if the block
+// was connected before the index existed, in which case the mints need to be read from the block.
+static bool GetIndexedBlockPubcoins(const CBlockIndex* pindex, CoinDenomination denom, std::list<PublicCoin>& listPubcoins)
+{
+    std::vector<CBigNum> vPubcoins;
+    if (!pzerocoinDB->ReadBlockPubcoins(pindex->nHeight, denom, pindex->GetBlockHash(), vPubcoins))
+        return false;
+
+    if ((int)vPubcoins.size() != count(pindex->vMintDenominationsInBlock.begin(), pindex->vMintDenominationsInBlock.end(), denom))
+        return false;
+
+    for (const CBigNum& bnValue : vPubcoins)
+        listPubcoins.emplace_back(Params().Zerocoin_Params(), bnValue, denom);
+    return true;
+}
+
+// Get the pubcoins minted in a block, from the pubcoin index if it has them
+static bool BlockIndexToPubcoinList(const CBlockIndex* pindex, std::list<PublicCoin>& listPubcoins)
+{
+    if (pindex->vMintDenominationsInBlock.empty())
+        return true;
+
+    bool fIndexed = true;
+    for (const CoinDenomination denom : zerocoinDenomList) {
+        if (pindex->MintedDenomination(denom) && !GetIndexedBlockPubcoins(pindex, denom, listPubcoins)) {
+            fIndexed = false;
+            break;
+        }
+    }
+    if (fIndexed)
+        return true;
+
+    listPubcoins.clear();
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+        return error("%s: failed to read block from disk", __func__);
+
+    return BlockToPubcoinList(block, listPubcoins);
+}
+
 //Get checkpoint value for a specific block height
 bool CalculateAccumulatorCheckpoint(int nHeight, std::map<libzerocoin::CoinDenomination, uint256>& mapCheckpoints, AccumulatorMap& mapAccumulators)
 {
@@ -233,27 +273,23 @@ bool CalculateAccumulatorCheckpoint(int nHeight, std::map<libzerocoin::CoinDenom
     if (!pindex)
         return false;
 
+    std::vector<PublicCoin> vPubcoins;
     while (pindex->nHeight < nHeight - 10) {
         //grab mints from this block
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
-            return error("%s: failed to read block from disk", __func__);
-
         std::list<PublicCoin> listPubcoins;
-        if (!BlockToPubcoinList(block, listPubcoins))
+        if (!BlockIndexToPubcoinList(pindex, listPubcoins))
             return error("%s: failed to get zerocoin mintlist from block %d", __func__, pindex->nHeight);
 
         nTotalMintsFound += listPubcoins.size();
-
-        //add the pubcoins to accumulator
-        for (const PublicCoin& pubcoin : listPubcoins) {
-            if(!mapAccumulators.Accumulate(pubcoin, true))
-                return error("%s: failed to add pubcoin to accumulator at height %d", __func__, pindex->nHeight);
-        }
+        vPubcoins.insert(vPubcoins.end(), listPubcoins.begin(), listPubcoins.end());
 
         pindex = chainActive.Next(pindex);
     }
 
+    //add the pubcoins of the whole range to the accumulators in batches
+    if (!mapAccumulators.Accumulate(vPubcoins, true))
+        return error("%s: failed to add pubcoins to accumulator at height %d", __func__, nHeight);
+
     // if there were no new mints found, the accumulator checkpoint will be the same as the last checkpoint
     if (nTotalMintsFound == 0) {
         mapCheckpoints = chainActive[nHeight - 1]->mapAccumulatorHashes;
@@ -325,8 +361,9 @@ int ComputeAccumulatedCoins(int nHeightEnd, libzerocoin::CoinDenomination denom)
     return n;
 }
 
-int AddBlockMintsToAccumulator(const libzerocoin::PublicCoin& coin, const int nHeightMintAdded, const CBlockIndex* pindex,
-                           libzerocoin::Accumulator* accumulator, bool isWitness)
+//Collect the values of the mints in this block that need to be accumulated, so that they can be applied in batches
+int GetBlockMintValues(const libzerocoin::PublicCoin& coin, const int nHeightMintAdded, const CBlockIndex* pindex,
+                       std::vector<CBigNum>& vValues, bool isWitness)
 {
     // if this block contains mints of the denomination that is being spent, then add them to the witness
     if (!pindex->MintedDenomination(coin.getDenomination()))
@@ -336,7 +373,7 @@ int AddBlockMintsToAccumulator(const libzerocoin::PublicCoin& coin, const int nH
     int nHeight = pindex->nHeight;
     list<PublicCoin> listPubcoins;
     //Do not keep cs_main locked during modular exponentiation (unless this is already locked from the validation)
-    {
+    if (!GetIndexedBlockPubcoins(pindex, coin.getDenomination(), listPubcoins)) {
         //grab mints from this block
         CBlock block;
         if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
@@ -354,7 +391,7 @@ int AddBlockMintsToAccumulator(const libzerocoin::PublicCoin& coin, const int nH
         if (isWitness && nHeight == nHeightMintAdded && pubcoin.getValue() == coin.getValue())
             continue;
 
-        accumulator->increment(pubcoin.getValue());
+        vValues.emplace_back(pubcoin.getValue());
         ++nMintsAdded;
     }
 
@@ -422,6 +459,7 @@ bool GenerateAccumulatorWitness(const PublicCoin &coin, Accumulator& accumulator
     nMintsAdded = 0;
     RandomizeSecurityLevel(nSecurityLevel); //make security level not always the same and predictable
     libzerocoin::Accumulator witnessAccumulator = accumulator;
+    std::vector<CBigNum> vWitnessValues;
 
     while (pindex) {
         {
@@ -446,10 +484,12 @@ bool GenerateAccumulatorWitness(const PublicCoin &coin, Accumulator& accumulator
         }
 
         //Do not lock cs_main here so that computation does not leave everything else bound up
-        nMintsAdded += AddBlockMintsToAccumulator(coin, nHeightMintAdded, pindex, &witnessAccumulator, true);
+        nMintsAdded += GetBlockMintValues(coin, nHeightMintAdded, pindex, vWitnessValues, true);
         pindex = chainActive.Next(pindex);
     }
 
+    //Apply the collected mints with one exponentiation per batch rather than one per mint
+    witnessAccumulator.increment(vWitnessValues);
     witness.resetValue(witnessAccumulator, coin);
     if (!witness.VerifyWitness(accumulator, coin))
         return error("%s: failed to verify witness", __func__);
@@ -14,8 +14,12 @@
 #include "primitives/zerocoin.h"
 #include "ui_interface.h"
 #include "mintmeta.h"
+#include "shutdown.h"
+#include "veil/workerpool.h"
 
-#include <boost/thread.hpp>
+#include <util.h>
+
+#include <atomic>
 
 // 6 comes from OPCODE (1) + vch.size() (1) + BIGNUM size (4)
 #define SCRIPT_OFFSET 6
@@ -76,48 +80,57 @@ bool BlockToPubcoinList(const CBlock& block, std::list<libzerocoin::PublicCoin>&
     return true;
 }
 
-bool ThreadedBatchVerify(const std::vector<libzerocoin::SerialNumberSoKProof>* pvProofs, int nThreads)
+//! Proofs checked by validation, under cs_main
+static CCheckQueue<CSerialNumberSoKCheck> sokcheckqueue(1);
+//! Proofs checked by ThreadedBatchVerify, which is called without cs_main while blocks are staged
+static CCheckQueue<CSerialNumberSoKCheck> sokstagingqueue(1);
+
+void ThreadSerialNumberSoKCheck()
 {
-    int64_t nMaxThreads = gArgs.GetArg("-threadbatchverify", DEFAULT_BATCHVERIFY_THREADS);
-    if (nThreads != -1)
-        nMaxThreads = nThreads;
+    RenameThread("veil-zkpcheck");
+    sokcheckqueue.Thread();
+}
 
-    // Assume that it doesn't give any gain to multithread, unless each thread has at least 6 proofs
-    int nThreadEfficiency = 7;
-
-    std::vector<std::vector<const libzerocoin::SerialNumberSoKProof*>> vProofGroups(1);
-    int nThreadsUsed = 1;
-    if ((int)pvProofs->size() > nThreadEfficiency)
-        nThreadsUsed = pvProofs->size() / nThreadEfficiency;
-    if (nThreadsUsed > nMaxThreads)
-        nThreadsUsed = nMaxThreads;
-
-    vProofGroups.resize(nThreadsUsed);
-    std::vector<uint8_t> vReturn(nThreadsUsed);
-    int nThreadSelected = 0;
-
-    for (unsigned int i = 0; i < pvProofs->size(); i++) {
-        vProofGroups[nThreadSelected].emplace_back(&pvProofs->at(i));
-        nThreadSelected++;
-        if (nThreadSelected >= nThreadsUsed)
-            nThreadSelected = 0;
-    }
+void ThreadStagingSoKCheck()
+{
+    RenameThread("veil-zkpstage");
+    sokstagingqueue.Thread();
+}
 
-    boost::thread_group threadGroup;
-    for (unsigned int i = 0; i < vProofGroups.size(); i++) {
-        threadGroup.create_thread([i, &vProofGroups, &vReturn] {
-            return libzerocoin::SerialNumberSoKProof::BatchVerify(vProofGroups[i], &vReturn[i]);
-        });
-    }
+CCheckQueue<CSerialNumberSoKCheck>* GetBatchVerifyQueue()
+{
+    return &sokcheckqueue;
+}
 
-    threadGroup.join_all();
+void QueueBatchVerify(const std::vector<libzerocoin::SerialNumberSoKProof>* pvProofs, CCheckQueueControl<CSerialNumberSoKCheck>& control, int nThreads)
+{
+    int64_t nMaxThreads = gArgs.GetArg("-threadbatchverify", DEFAULT_BATCHVERIFY_THREADS);
+    if (nThreads != -1)
+        nMaxThreads = nThreads;
 
-    for (auto ret : vReturn) {
-        if (ret != 1)
-            return false;
-    }
+    // Each group is verified as one batch, and a batch costs less per proof the larger it is. Give every thread
+    // that takes part in the verification one group of about the same size.
+    int nGroups = std::min<int64_t>(std::max<int64_t>(nMaxThreads, 1), pvProofs->size());
+    if (nGroups < 1)
+        nGroups = 1;
+    size_t nGroupSize = (pvProofs->size() + nGroups - 1) / nGroups;
+
+    std::vector<std::vector<const libzerocoin::SerialNumberSoKProof*>> vProofGroups(nGroups);
+    for (unsigned int i = 0; i < pvProofs->size(); i++)
+        vProofGroups[i / nGroupSize].emplace_back(&pvProofs->at(i));
+
+    std::vector<CSerialNumberSoKCheck> vChecks;
+    vChecks.reserve(nGroups);
+    for (auto& vGroup : vProofGroups)
+        vChecks.emplace_back(std::move(vGroup));
+    control.Add(vChecks);
+}
 
-    return true;
+bool ThreadedBatchVerify(const std::vector<libzerocoin::SerialNumberSoKProof>* pvProofs, int nThreads)
+{
+    CCheckQueueControl<CSerialNumberSoKCheck> control(&sokstagingqueue);
+    QueueBatchVerify(pvProofs, control, nThreads);
+    return control.Wait();
 }
 
 bool TxToPubcoinHashSet(const CTransaction* tx, std::set<uint256>& setHashes)
@@ -325,78 +338,156 @@ bool IsSerialInBlockchain(const uint256& hashSerial, int& nHeightTx, uint256& tx
     return IsTransactionInChain(txidSpend, nHeightTx, txRef, Params().GetConsensus());
 }
 
-std::string ReindexZerocoinDB()
+bool BlockHasZerocoins(const CBlockIndex* pindex)
+{
+    if (!pindex->vMintDenominationsInBlock.empty())
+        return true;
+
+    // The supply adjustment at the light zerocoin fork doesn't come from the block's transactions
+    if (!pindex->pprev || pindex->nHeight == Params().HeightLightZerocoin())
+        return true;
+
+    // Without mints in the block, a change in the supply of a denomination can only come from spends
+    for (auto denom : libzerocoin::zerocoinDenomList) {
+        if (pindex->mapZerocoinSupply.at(denom) != pindex->pprev->mapZerocoinSupply.at(denom))
+            return true;
+    }
+
+    return false;
+}
+
+static bool ReadZerocoinBlockRecords(const CBlockIndex* pindex, CZerocoinBlockRecords& records)
 {
     auto zerocoinParams = Params().Zerocoin_Params();
 
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+        return error("%s: failed to read block %s", __func__, pindex->GetBlockHash().GetHex());
+
+    records.pindex = pindex;
+    for (const CTransactionRef& tx : block.vtx) {
+        if (tx->IsCoinBase() || !tx->ContainsZerocoins())
+            continue;
+
+        uint256 txid = tx->GetHash();
+        //Record Serials
+        if (tx->IsZerocoinSpend()) {
+            for (auto& in : tx->vin) {
+                if (!in.IsZerocoinSpend())
+                    continue;
+
+                auto spend = TxInToZerocoinSpend(in);
+                if (spend)
+                    records.vSpends.emplace_back(*spend, txid);
+            }
+        }
+
+        //Record mints
+        if (tx->IsZerocoinMint()) {
+            for (auto& out : tx->vpout) {
+                if (!out->IsZerocoinMint())
+                    continue;
+
+                libzerocoin::PublicCoin coin(zerocoinParams);
+                OutputToPublicCoin(out.get(), coin);
+                records.vMints.emplace_back(coin, txid);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ScanZerocoinBlocks(const std::vector<const CBlockIndex*>& vBlocks, const std::function<bool(const CZerocoinBlockRecords&)>& fnProcess, int nThreads)
+{
+    nThreads = std::max(1, nThreads);
+    const size_t nWindow = (size_t)nThreads * ZEROCOIN_SCAN_BLOCKS_PER_THREAD;
+    std::atomic<bool> fFailed(false);
+
+    // Each round, task 0 processes the window read in the previous round, while the other tasks read the next
+    // window. The worker pool runs them side by side.
+    std::vector<CZerocoinBlockRecords> vCurrent;
+    std::vector<CZerocoinBlockRecords> vNext;
+    for (size_t nBegin = 0; nBegin < vBlocks.size() + nWindow && !fFailed; nBegin += nWindow) {
+        const size_t nEnd = std::min(nBegin + nWindow, vBlocks.size());
+        vNext.assign(nBegin < nEnd ? nEnd - nBegin : 0, CZerocoinBlockRecords());
+
+        veil::workerPool.Run(nThreads + 1, [&](size_t nTask) {
+            if (nTask == 0) {
+                for (const CZerocoinBlockRecords& records : vCurrent) {
+                    if (fFailed || ShutdownRequested())
+                        break;
+                    if (!fnProcess(records))
+                        fFailed = true;
+                }
+                return;
+            }
+
+            try {
+                for (size_t i = nTask - 1; i < vNext.size() && !fFailed; i += nThreads) {
+                    if (!ReadZerocoinBlockRecords(vBlocks[nBegin + i], vNext[i]))
+                        fFailed = true;
+                }
+            } catch (const std::exception& e) {
+                LogPrintf("%s: %s\n", __func__, e.what());
+                fFailed = true;
+            }
+        });
+
+        if (ShutdownRequested())
+            break;
+        vCurrent.swap(vNext);
+    }
+
+    return !fFailed && !ShutdownRequested();
+}
+
+std::string ReindexZerocoinDB()
+{
     if (!pzerocoinDB->WipeCoins("spends") || !pzerocoinDB->WipeCoins("mints")) {
         return _("Failed to wipe zerocoinDB");
     }
 
     uiInterface.ShowProgress(_("Reindexing zerocoin database..."), 0, false);
 
-    CBlockIndex* pindex = chainActive[0];
+    // Only blocks that the block index records as having zerocoin mints or spends need to be read
+    std::vector<const CBlockIndex*> vBlocks;
+    for (CBlockIndex* pindex = chainActive[0]; pindex; pindex = chainActive.Next(pindex)) {
+        if (BlockHasZerocoins(pindex))
+            vBlocks.emplace_back(pindex);
+    }
+    LogPrintf("Reindexing zerocoin : %d of %d blocks contain zerocoins\n", vBlocks.size(), chainActive.Height() + 1);
+
     std::map<libzerocoin::CoinSpend, uint256> mapSpends;
     std::map<libzerocoin::PublicCoin, uint256> mapMints;
-    while (pindex) {
+    int nHeightLastFlush = 0;
+    auto process = [&](const CZerocoinBlockRecords& records) {
+        const CBlockIndex* pindex = records.pindex;
         uiInterface.ShowProgress(_("Reindexing zerocoin database..."), std::max(1, std::min(99,
                 (int)((double) (pindex->nHeight) / (double)(chainActive.Height()) * 100))), false);
 
-        if (pindex->nHeight % 1000 == 0)
-            LogPrintf("Reindexing zerocoin : block %d...\n", pindex->nHeight);
-
-        CBlock block;
-        if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
-            return _("Reindexing zerocoin failed");
-        }
-
-        for (const CTransactionRef tx : block.vtx) {
-            for (unsigned int i = 0; i < tx->vin.size(); i++) {
-                if (tx->IsCoinBase())
-                    break;
-
-                if (tx->ContainsZerocoins()) {
-                    uint256 txid = tx->GetHash();
-                    //Record Serials
-                    if (tx->IsZerocoinSpend()) {
-                        for (auto& in : tx->vin) {
-                            if (!in.IsZerocoinSpend())
-                                continue;
-
-                            auto spend = TxInToZerocoinSpend(in);
-                            if (spend)
-                                mapSpends.emplace(*spend, txid);
-                        }
-                    }
-
-                    //Record mints
-                    if (tx->IsZerocoinMint()) {
-                        for (auto& out : tx->vpout) {
-                            if (!out->IsZerocoinMint())
-                                continue;
-
-                            CValidationState state;
-                            libzerocoin::PublicCoin coin(zerocoinParams);
-                            OutputToPublicCoin(out.get(), coin);
-                            mapMints.emplace(coin, txid);
-                        }
-                    }
-                }
-            }
-        }
+        for (const auto& pSpend : records.vSpends)
+            mapSpends.emplace(pSpend.first, pSpend.second);
+        for (const auto& pMint : records.vMints)
+            mapMints.emplace(pMint.first, pMint.second);
 
         // Flush the zerocoinDB to disk every 100 blocks
-        if (pindex->nHeight % 100 == 0) {
+        if (pindex->nHeight - nHeightLastFlush >= 100) {
+            LogPrintf("Reindexing zerocoin : block %d...\n", pindex->nHeight);
             if ((!mapSpends.empty() && !pzerocoinDB->WriteCoinSpendBatch(mapSpends)) || (!mapMints.empty()
                 && !pzerocoinDB->WriteCoinMintBatch(mapMints)))
-                return _("Error writing zerocoinDB to disk");
+                return error("Error writing zerocoinDB to disk");
             mapSpends.clear();
             mapMints.clear();
+            nHeightLastFlush = pindex->nHeight;
         }
+        return true;
+    };
 
-        pindex = chainActive.Next(pindex);
+    if (!ScanZerocoinBlocks(vBlocks, process, GetNumCores())) {
+        uiInterface.ShowProgress("", 100, false);
+        return _("Reindexing zerocoin failed");
     }
-    uiInterface.ShowProgress("", 100, false);
 
     // Final flush to disk in case any remaining information exists
     if ((!mapSpends.empty() && !pzerocoinDB->WriteCoinSpendBatch(mapSpends)) || (!mapMints.empty() &&
@@ -9,6 +9,8 @@
 #include "libzerocoin/Coin.h"
 #include "libzerocoin/Denominations.h"
 #include "libzerocoin/CoinSpend.h"
+#include <checkqueue.h>
+#include <functional>
 #include <list>
 #include <string>
 #include <primitives/transaction.h>
@@ -24,6 +26,53 @@ class CValidationState;
 class CZerocoinMint;
 class uint256;
 
+/**
+ * Closure representing the batch verification of one group of serial number signatures of knowledge.
+ * Note that this stores pointers to the proofs, which have to outlive the check.
+ */
+class CSerialNumberSoKCheck
+{
+private:
+    std::vector<const libzerocoin::SerialNumberSoKProof*> vProofs;
+
+public:
+    CSerialNumberSoKCheck() {}
+    explicit CSerialNumberSoKCheck(std::vector<const libzerocoin::SerialNumberSoKProof*>&& vProofsIn) : vProofs(std::move(vProofsIn)) {}
+
+    bool operator()() { return vProofs.empty() || libzerocoin::SerialNumberSoKProof::BatchVerify(vProofs); }
+
+    void swap(CSerialNumberSoKCheck& check) { vProofs.swap(check.vProofs); }
+};
+
+/** Run an instance of the zerocoin proof batch verification thread */
+void ThreadSerialNumberSoKCheck();
+/** Run an instance of the batch verification thread for ThreadedBatchVerify */
+void ThreadStagingSoKCheck();
+/** Start verifying the proofs on the batch verification threads. The result is returned by control.Wait(). */
+void QueueBatchVerify(const std::vector<libzerocoin::SerialNumberSoKProof>* pvProofs, CCheckQueueControl<CSerialNumberSoKCheck>& control, int nThreads = -1);
+/** Get the queue used by validation, for constructing a CCheckQueueControl. Only use it while holding cs_main. */
+CCheckQueue<CSerialNumberSoKCheck>* GetBatchVerifyQueue();
+
+//! Number of blocks each task reads ahead of the consumer in ScanZerocoinBlocks
+static const int ZEROCOIN_SCAN_BLOCKS_PER_THREAD = 16;
+
+/** The zerocoin mints and spends of one block, as extracted by ScanZerocoinBlocks */
+struct CZerocoinBlockRecords
+{
+    const CBlockIndex* pindex = nullptr;
+    std::vector<std::pair<libzerocoin::CoinSpend, uint256> > vSpends;
+    std::vector<std::pair<libzerocoin::PublicCoin, uint256> > vMints;
+};
+
+/** Whether the block index records zerocoin mints or spends in this block */
+bool BlockHasZerocoins(const CBlockIndex* pindex);
+/**
+ * Read vBlocks in nThreads tasks on veil::workerPool and extract their zerocoin mints and spends. The records are passed to
+ * fnProcess in the order of vBlocks while the following blocks are read. Returns false if a block could not
+ * be read or fnProcess returned false.
+ */
+bool ScanZerocoinBlocks(const std::vector<const CBlockIndex*>& vBlocks, const std::function<bool(const CZerocoinBlockRecords&)>& fnProcess, int nThreads);
+
 bool BlockToMintValueVector(const CBlock& block, const libzerocoin::CoinDenomination denom, std::vector<CBigNum>& vValues);
 bool BlockToPubcoinList(const CBlock& block, std::list<libzerocoin::PublicCoin>& listPubcoins);
 bool TxToPubcoinHashSet(const CTransaction* tx, std::set<uint256>& setHashes);
@@ -0,0 +1,111 @@
+// Copyright (c) 2021 Veil developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef VEIL_ZHASHINDEX_H
+#define VEIL_ZHASHINDEX_H
+
+#include <sync.h>
+#include <uint256.h>
+
+#include <algorithm>
+#include <vector>
+
+//! -zerocoinhashindex default
+static const bool DEFAULT_ZEROCOIN_HASH_INDEX = true;
+
+namespace veil {
+
+/**
+ * The ZerocoinHashIndex keeps the first 64 bits of every serial or pubcoin hash that
+ * is stored in the zerocoin db, so that a lookup of a hash that is not in the db can
+ * be answered without touching disk.
+ *
+ * The index is a superset of the db: a negative answer is definitive, a positive answer
+ * has to be confirmed by reading the db. Entries are never removed when the db entry is
+ * erased, since a truncated hash may be shared by several db entries.
+ *
+ * Hashes are kept in a sorted vector, with recent additions collected in a small unsorted
+ * buffer that is merged in once it reaches MERGE_SIZE. Uses an internal mutex to prevent
+ * concurrent access.
+ */
+class ZerocoinHashIndex
+{
+public:
+    static const size_t MERGE_SIZE = 1024;
+
+private:
+    std::vector<uint64_t> vSorted;
+    std::vector<uint64_t> vRecent;
+    bool fLoaded;
+    mutable CCriticalSection cs_index;
+
+    void Merge()
+    {
+        std::sort(vRecent.begin(), vRecent.end());
+        size_t nMid = vSorted.size();
+        vSorted.insert(vSorted.end(), vRecent.begin(), vRecent.end());
+        std::inplace_merge(vSorted.begin(), vSorted.begin() + nMid, vSorted.end());
+        vRecent.clear();
+    }
+
+public:
+    ZerocoinHashIndex() : fLoaded(false) {}
+
+    //! Replace the contents of the index. Until this is called every hash may be in the db.
+    void Load(std::vector<uint64_t>&& vHashes)
+    {
+        std::sort(vHashes.begin(), vHashes.end());
+        LOCK(cs_index);
+        vSorted = std::move(vHashes);
+        vRecent.clear();
+        fLoaded = true;
+    }
+
+    void Add(const uint256& hash)
+    {
+        LOCK(cs_index);
+        if (!fLoaded)
+            return;
+        vRecent.emplace_back(hash.GetUint64(0));
+        if (vRecent.size() >= MERGE_SIZE)
+            Merge();
+    }
+
+    //! Returns false only if the hash is known not to be in the db
+    bool MaybeContains(const uint256& hash) const
+    {
+        LOCK(cs_index);
+        if (!fLoaded)
+            return true;
+        const uint64_t nKey = hash.GetUint64(0);
+        return std::binary_search(vSorted.begin(), vSorted.end(), nKey) ||
+               std::find(vRecent.begin(), vRecent.end(), nKey) != vRecent.end();
+    }
+
+    bool IsLoaded() const
+    {
+        LOCK(cs_index);
+        return fLoaded;
+    }
+
+    size_t Size() const
+    {
+        LOCK(cs_index);
+        return vSorted.size() + vRecent.size();
+    }
+
+    //! Stop answering from the index, every hash is assumed to be in the db until Load() is called again
+    void Unload()
+    {
+        LOCK(cs_index);
+        vSorted.clear();
+        vSorted.shrink_to_fit();
+        vRecent.clear();
+        fLoaded = false;
+    }
+};
+
+} // namespace veil
+
+#endif // VEIL_ZHASHINDEX_H
@@ -14,6 +14,9 @@
 #include "consensus/validation.h"
 #include "shutdown.h"
 #include "boost/thread.hpp"
+#include "veil/workerpool.h"
+
+#include <atomic>
 
 using namespace libzerocoin;
 
@@ -110,42 +113,27 @@ void CzWallet::GenerateMintPool(uint32_t nCountStart, uint32_t nCountEnd)
     if (nCountEnd > 0)
         nStop = std::max(n, n + nCountEnd);
 
-    bool fFound;
-
     if (!mapMasterSeeds.count(seedMasterID)) {
         LogPrintf("%s: do not have master seed with ID %s loaded!", __func__, seedMasterID.GetHex());
         return;
     }
 
     LogPrintf("%s : n=%d nStop=%d\n", __func__, n, nStop - 1);
-    for (uint32_t i = n; i < nStop; ++i) {
-        if (ShutdownRequested())
-            return;
 
-        fFound = false;
+    // Prevent unnecessary repeated minted
+    std::set<uint32_t> setPoolCounts;
+    for (auto& pair : mintPool)
+        setPoolCounts.insert(pair.second);
 
-        // Prevent unnecessary repeated minted
-        for (auto& pair : mintPool) {
-            if(pair.second == i) {
-                fFound = true;
-                break;
-            }
-        }
-
-        if(fFound)
-            continue;
-
-        uint512 seedZerocoin = GetZerocoinSeed(seedMasterID, i);
-        CBigNum bnValue;
-        CBigNum bnSerial;
-        CBigNum bnRandomness;
-        CKey key;
-        SeedToZerocoin(seedZerocoin, bnValue, bnSerial, bnRandomness, key);
-
-        mintPool.Add(bnValue, i);
-        WalletBatch(*walletDatabase).WriteMintPoolPair(seedMasterID, GetPubCoinHash(bnValue), i);
-        LogPrintf("%s : %s count=%d\n", __func__, bnValue.GetHex().substr(0, 6), i);
+    std::vector<uint32_t> vCounts;
+    for (uint32_t i = n; i < nStop; ++i) {
+        if (!setPoolCounts.count(i))
+            vCounts.emplace_back(i);
     }
+
+    int nThreads = GetNumCores();
+    bool fShowProgress = vCounts.size() > (size_t)nThreads * ZWALLET_MINTS_PER_THREAD_BATCH;
+    AddCountsToMintPool(mapMasterSeeds.at(seedMasterID), vCounts, nThreads, fShowProgress);
 }
 
 // pubcoin hashes are stored to db so that a full accounting of mints belonging to the seed can be tracked without regenerating
@@ -282,123 +270,105 @@ void CzWallet::SyncWithChain(bool fGenerateMintPool)
         }
     }
 }
-int *ThreadedDeterministicSearch_nProgress = nullptr;
-int ThreadedDeterministicSearch_nThreads = 0;
-int ThreadedDeterministicSearch_nCountStart = 0;
-int ThreadedDeterministicSearch_nCountEnd = 0;
 
 void CzWallet::ThreadedDeterministicSearch(int nCountStart, int nCountEnd, int nThreads)
 {
-    static boost::thread_group* searchThreads = nullptr;
-    int nCount = nCountStart;
-    int nRange = nCountEnd - nCountStart;
-
-    if (nThreads < 1) {
-        nThreads = 1;
-    }
-
-    if (searchThreads) {
-        searchThreads->interrupt_all();
-        delete searchThreads;
-        searchThreads = nullptr;
-    }
-
-    uiInterface.ShowProgress(_("Searching..."), 0, false); // show search progress in GUI as dialog or on splashscreen
-
-    if (ThreadedDeterministicSearch_nProgress) {
-        delete[] ThreadedDeterministicSearch_nProgress;
-        ThreadedDeterministicSearch_nProgress = nullptr;
-    }
+    DeterministicSearch(nCountStart, nCountEnd, std::max(1, nThreads));
+}
 
-    ThreadedDeterministicSearch_nThreads = nThreads;
-    ThreadedDeterministicSearch_nProgress = new int[nThreads];
-    for (int i=0 ;i < ThreadedDeterministicSearch_nThreads; i++) {
-        ThreadedDeterministicSearch_nProgress[i] = 0;
-    }
-    ThreadedDeterministicSearch_nCountStart = nCountStart;
-    ThreadedDeterministicSearch_nCountEnd = nCountEnd;
+bool CzWallet::DeterministicSearch(int nCountStart, int nCountEnd, int nThreads)
+{
+    LogPrintf("%s: start=%d end=%d\n", __func__, nCountStart, nCountEnd);
+    try {
+        CKey keyMaster;
+        if (!GetMasterSeed(keyMaster))
+            return false;
 
-    searchThreads = new boost::thread_group();
+        std::vector<uint32_t> vCounts;
+        for (int i = nCountStart; i < nCountEnd; i++)
+            vCounts.emplace_back(i);
 
-    int nRangePerThread = nRange / nThreads;
+        if (nThreads < 1)
+            nThreads = GetNumCores();
 
-    int nPrevThreadEnd = nCount - 1;
-    for (int i = 0; i < nThreads; i++) {
-        int nStart = nPrevThreadEnd + 1;;
-        int nEnd = std::min(nStart + nRangePerThread, nCountEnd);
-        nPrevThreadEnd = nEnd;
-        searchThreads->create_thread(std::bind(&CzWallet::DeterministicSearch, this, nStart, nEnd, &ThreadedDeterministicSearch_nProgress[i]));
+        return AddCountsToMintPool(keyMaster, vCounts, nThreads, true);
+    } catch (...) {
+        uiInterface.ShowProgress(_("Searching..."), 100, false);
+        return error("%s: caught exception while running", __func__);
     }
+}
 
-    searchThreads->join_all();
+/**
+ * Derive the pubcoin hashes of the deterministic mints at vCounts of the master seed.
+ * SeedToZerocoin dominates the cost, so the counts are split into nThreads tasks on veil::workerPool.
+ */
+bool CzWallet::GenerateMintHashes(const CKey& keyMaster, const std::vector<uint32_t>& vCounts, int nThreads, std::vector<uint256>& vHashes)
+{
+    vHashes.assign(vCounts.size(), uint256());
+    std::atomic<bool> fFailed(false);
+
+    nThreads = std::max(nThreads, 1);
+    veil::workerPool.Run(std::min((size_t)nThreads, vCounts.size()), [&](size_t nFirst) {
+        try {
+            for (size_t i = nFirst; i < vCounts.size() && !fFailed; i += nThreads) {
+                CDataStream ss(SER_GETHASH, 0);
+                ss << keyMaster.GetPrivKey_256() << vCounts[i];
+                uint512 seedZerocoin = Hash512(ss.begin(), ss.end());
+
+                CBigNum bnValue;
+                CBigNum bnSerial;
+                CBigNum bnRandomness;
+                CKey key;
+                SeedToZerocoin(seedZerocoin, bnValue, bnSerial, bnRandomness, key);
+                vHashes[i] = GetPubCoinHash(bnValue);
+            }
+        } catch (const std::exception& e) {
+            LogPrintf("%s: %s\n", __func__, e.what());
+            fFailed = true;
+        }
+    });
 
-    uiInterface.ShowProgress(_("Searching..."), 100, 0); // hide progress dialog in GUI
+    return !fFailed;
 }
 
-bool CzWallet::DeterministicSearch(int nCountStart, int nCountEnd, int* nThreadedProgress)
+bool CzWallet::AddCountsToMintPool(const CKey& keyMaster, const std::vector<uint32_t>& vCounts, int nThreads, bool fShowProgress)
 {
-    LogPrintf("%s: start=%d end=%d\n", __func__, nCountStart, nCountEnd);
-    try {
-        double progress_begin;
-        double progress_end;
-        double progress_current;
+    if (fShowProgress)
+        uiInterface.ShowProgress(_("Searching..."), 0, false); // show search progress in GUI
 
-        if (nThreadedProgress == nullptr) {
-            progress_begin = nCountStart;
-            progress_end = nCountEnd;
+    CKeyID hashSeed = keyMaster.GetPubKey().GetID();
+    size_t nBatchSize = (size_t)nThreads * ZWALLET_MINTS_PER_THREAD_BATCH;
+    for (size_t nStart = 0; nStart < vCounts.size(); nStart += nBatchSize) {
+        boost::this_thread::interruption_point();
+        if (ShutdownRequested())
+            break;
 
-            uiInterface.ShowProgress(_("Searching..."), 0, false); // show search progress in GUI
-        }
-        else {
-            progress_begin = ThreadedDeterministicSearch_nCountStart;
-            progress_end = ThreadedDeterministicSearch_nCountEnd - ThreadedDeterministicSearch_nThreads;
+        std::vector<uint32_t> vBatch(vCounts.begin() + nStart, vCounts.begin() + std::min(nStart + nBatchSize, vCounts.size()));
+        std::vector<uint256> vHashes;
+        if (!GenerateMintHashes(keyMaster, vBatch, nThreads, vHashes)) {
+            if (fShowProgress)
+                uiInterface.ShowProgress(_("Searching..."), 100, false);
+            return error("%s: failed to generate mints %d to %d", __func__, vBatch.front(), vBatch.back());
         }
 
-        CKey keyMaster;
-        if (!GetMasterSeed(keyMaster))
-            return false;
-
+        // Write the whole batch in one wallet db transaction
         WalletBatch walletdb(*walletDatabase);
-
-        CKeyID hashSeed = keyMaster.GetPubKey().GetID();
-        for(int i = nCountStart; i < nCountEnd; i++) {
-            boost::this_thread::interruption_point();
-
-            CDataStream ss(SER_GETHASH, 0);
-            ss << keyMaster.GetPrivKey_256() << i;
-            uint512 zerocoinSeed = Hash512(ss.begin(), ss.end());
-
-            CBigNum bnValue;
-            CBigNum bnSerial;
-            CBigNum bnRandomness;
-            CKey key;
-            SeedToZerocoin(zerocoinSeed, bnValue, bnSerial, bnRandomness, key);
-
-            uint256 hashPubcoin = GetPubCoinHash(bnValue);
-            AddToMintPool(make_pair(hashPubcoin, i), true);
-            walletdb.WriteMintPoolPair(hashSeed, hashPubcoin, i);
-
-            if (nThreadedProgress == nullptr) {
-                progress_current = i;
-            } else {
-                // Calculate combined progress
-                progress_current = 0;
-                *nThreadedProgress = i - nCountStart + 1;
-                for (int i = 0; i < ThreadedDeterministicSearch_nThreads; i++) {
-                    progress_current += ThreadedDeterministicSearch_nProgress[i];
-                }
-            }
-
-            int percentageDone = std::max(1, std::min(99, (int)((progress_current - progress_begin) / (progress_end - progress_begin) * 100)));
-            uiInterface.ShowProgress(_("Searching..."), percentageDone, 0);
+        walletdb.TxnBegin();
+        for (size_t i = 0; i < vBatch.size(); i++) {
+            AddToMintPool(std::make_pair(vHashes[i], vBatch[i]), true);
+            walletdb.WriteMintPoolPair(hashSeed, vHashes[i], vBatch[i]);
         }
-        if (nThreadedProgress == nullptr) {
-            uiInterface.ShowProgress(_("Searching..."), 100, 0); // hide progress dialog in GUI
+        walletdb.TxnCommit();
+
+        if (fShowProgress) {
+            int percentageDone = std::max(1, std::min(99, (int)((nStart + vBatch.size()) * 100 / vCounts.size())));
+            uiInterface.ShowProgress(_("Searching..."), percentageDone, false);
         }
-    } catch (...) {
-        return error("%s: caught exception while running", __func__);
     }
 
+    if (fShowProgress)
+        uiInterface.ShowProgress(_("Searching..."), 100, false); // hide progress dialog in GUI
+
     return true;
 }
 
@@ -506,8 +476,8 @@ void CzWallet::SeedToZerocoin(const uint512& seedZerocoin, CBigNum& bnValue, CBi
 
     //See if serial and randomness make a valid commitment
     // Generate a Pedersen commitment to the serial number
-    CBigNum commitmentValue = zerocoinParams->coinCommitmentGroup.g.pow_mod(bnSerial, zerocoinParams->coinCommitmentGroup.modulus).mul_mod(
-            zerocoinParams->coinCommitmentGroup.h.pow_mod(bnRandomness, zerocoinParams->coinCommitmentGroup.modulus),
+    CBigNum commitmentValue = zerocoinParams->coinCommitmentGroup.pow_g(bnSerial).mul_mod(
+            zerocoinParams->coinCommitmentGroup.pow_h(bnRandomness),
             zerocoinParams->coinCommitmentGroup.modulus);
 
     CBigNum random;
@@ -530,8 +500,8 @@ void CzWallet::SeedToZerocoin(const uint512& seedZerocoin, CBigNum& bnValue, CBi
                               hashAttempts.begin(), hashAttempts.end());
         random.setuint256(hashRandomness);
         bnRandomness = (bnRandomness + random) % zerocoinParams->coinCommitmentGroup.groupOrder;
-        commitmentValue = commitmentValue.mul_mod(zerocoinParams->coinCommitmentGroup.h.pow_mod(random,
-                zerocoinParams->coinCommitmentGroup.modulus), zerocoinParams->coinCommitmentGroup.modulus);
+        commitmentValue = commitmentValue.mul_mod(zerocoinParams->coinCommitmentGroup.pow_h(random),
+                zerocoinParams->coinCommitmentGroup.modulus);
     }
 }
 
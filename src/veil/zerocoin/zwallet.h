@@ -15,6 +15,9 @@
 
 class CDeterministicMint;
 
+//! Number of deterministic mints each thread derives per batch when filling the mint pool
+static const int ZWALLET_MINTS_PER_THREAD_BATCH = 10;
+
 class CzWallet
 {
 private:
@@ -29,7 +32,7 @@ public:
 
     void AddToMintPool(const std::pair<uint256, uint32_t>& pMint, bool fVerbose);
     void ThreadedDeterministicSearch(int nCountStart, int nCountEnd, int nThreads);
-    bool DeterministicSearch(int nCountStart, int nCountEnd, int* progress = nullptr);
+    bool DeterministicSearch(int nCountStart, int nCountEnd, int nThreads = 0);
     bool HasEmptySeed() const { return mapMasterSeeds.empty() || mapMasterSeeds.count(seedMasterID) == 0; }
     bool GetMasterSeed(CKey& key) const;
     CKeyID GetMasterSeedID() { return seedMasterID; }
@@ -51,6 +54,8 @@ public:
 
 private:
     uint512 GetZerocoinSeed(const CKeyID& keyID, uint32_t n);
+    bool GenerateMintHashes(const CKey& keyMaster, const std::vector<uint32_t>& vCounts, int nThreads, std::vector<uint256>& vHashes);
+    bool AddCountsToMintPool(const CKey& keyMaster, const std::vector<uint32_t>& vCounts, int nThreads, bool fShowProgress);
 };
 
 
@@ -17,7 +17,9 @@
 #include <wallet/rpcwallet.h>
 #include <wallet/wallet.h>
 #include <wallet/walletutil.h>
+#include <veil/proofofstake/kernel.h>
 #include <veil/ringct/anonwallet.h>
+#include <veil/ringct/decoyselector.h>
 #include <veil/zerocoin/zwallet.h>
 
 void WalletInit::AddWalletOptions() const
@@ -47,6 +49,7 @@ void WalletInit::AddWalletOptions() const
     gArgs.AddArg("-salvagewallet", "Attempt to recover private keys from a corrupt wallet on startup", false, OptionsCategory::WALLET);
     gArgs.AddArg("-spendzeroconfchange", strprintf("Spend unconfirmed change when sending transactions (default: %u)", DEFAULT_SPEND_ZEROCONF_CHANGE), false, OptionsCategory::WALLET);
     gArgs.AddArg("-staking", strprintf("Enable stake mining (default: %d)", true), false, OptionsCategory::WALLET);
+    gArgs.AddArg("-stakingthreads=<n>", strprintf("Set the number of threads that search the stakable zerocoins for a kernel (default: %d)", DEFAULT_STAKING_THREADS), false, OptionsCategory::WALLET);
     gArgs.AddArg("-txconfirmtarget=<n>", strprintf("If paytxfee is not set, include enough fee so transactions begin confirmation on average within n blocks (default: %u)", DEFAULT_TX_CONFIRM_TARGET), false, OptionsCategory::WALLET);
     gArgs.AddArg("-upgradewallet", "Upgrade wallet to latest format on startup", false, OptionsCategory::WALLET);
     gArgs.AddArg("-wallet=<path>", "Specify wallet database path. Can be specified multiple times to load multiple wallets. Path is interpreted relative to <walletdir> if it is not absolute, and will be created if it does not exist (as a directory containing a wallet.dat file and log files). For backwards compatibility this will also accept names of existing data files in <walletdir>.)", false, OptionsCategory::WALLET);
@@ -234,6 +237,20 @@ bool WalletInit::Open() const
     return true;
 }
 
+//! Read the decoy candidates one batch at a time, so that the scheduler thread is free for other tasks in between
+static void SyncDecoySelector(CScheduler& scheduler)
+{
+    std::string sError;
+    if (!veil::decoySelector.Sync(sError, veil::DECOY_SYNC_BATCH_OUTPUTS)) {
+        LogPrintf("%s: %s\n", __func__, sError);
+        return;
+    }
+
+    LOCK(cs_main);
+    if (!veil::decoySelector.IsSynced())
+        scheduler.schedule(std::bind(&SyncDecoySelector, std::ref(scheduler)));
+}
+
 void WalletInit::Start(CScheduler& scheduler) const
 {
     if (gArgs.GetBoolArg("-disablewallet", DEFAULT_DISABLE_WALLET)) {
@@ -247,6 +264,9 @@ void WalletInit::Start(CScheduler& scheduler) const
 
     // Run a thread to flush wallet periodically
     scheduler.scheduleEvery(MaybeCompactWalletDB, 500);
+
+    // Build the decoy index before the first RingCT transaction needs it
+    scheduler.schedule(std::bind(&SyncDecoySelector, std::ref(scheduler)));
 }
 
 void WalletInit::Flush() const
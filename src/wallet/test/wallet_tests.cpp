@@ -14,6 +14,7 @@
 #include <rpc/server.h>
 #include <test/test_veil.h>
 #include <validation.h>
+#include <veil/ringct/anonwallet.h>
 #include <wallet/coincontrol.h>
 #include <wallet/test/wallet_test_fixture.h>
 
@@ -374,4 +375,117 @@ BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup)
     BOOST_CHECK(!wallet->GetKeyFromPool(pubkey, false));
 }
 
+static COutputRecord OwnedOutput(uint16_t n, uint8_t nType, CAmount nValue)
+{
+    COutputRecord r;
+    r.n = n;
+    r.nType = nType;
+    r.nFlags = ORF_OWNED;
+    r.SetValue(nValue);
+    return r;
+}
+
+// Compare the balances from the balance ledger with the balances of a ledger rebuilt from all records
+static void CheckAnonLedger(AnonWallet& anon)
+{
+    BalanceList bal;
+    BOOST_CHECK(anon.GetBalances(bal));
+    CAmount nStandard = anon.GetBalance();
+    CAmount nSpendable = anon.GetSpendableBalance();
+    CAmount nBlind = anon.GetBlindBalance();
+    CAmount nAnon = anon.GetAnonBalance();
+    CAmount nAnonConfirmed = anon.GetAnonBalance(12);
+
+    anon.MarkDirty();
+    BalanceList balFull;
+    BOOST_CHECK(anon.GetBalances(balFull));
+    BOOST_CHECK_EQUAL(bal.nRingCT, balFull.nRingCT);
+    BOOST_CHECK_EQUAL(bal.nRingCTImmature, balFull.nRingCTImmature);
+    BOOST_CHECK_EQUAL(bal.nRingCTUnconf, balFull.nRingCTUnconf);
+    BOOST_CHECK_EQUAL(bal.nCT, balFull.nCT);
+    BOOST_CHECK_EQUAL(bal.nCTImmature, balFull.nCTImmature);
+    BOOST_CHECK_EQUAL(bal.nCTUnconf, balFull.nCTUnconf);
+    BOOST_CHECK_EQUAL(nStandard, anon.GetBalance());
+    BOOST_CHECK_EQUAL(nSpendable, anon.GetSpendableBalance());
+    BOOST_CHECK_EQUAL(nBlind, anon.GetBlindBalance());
+    BOOST_CHECK_EQUAL(nAnon, anon.GetAnonBalance());
+    BOOST_CHECK_EQUAL(nAnonConfirmed, anon.GetAnonBalance(12));
+}
+
+BOOST_FIXTURE_TEST_CASE(anon_balance_ledger, TestChain100Setup)
+{
+    std::shared_ptr<CWallet> wallet = std::make_shared<CWallet>("mock", WalletDatabase::CreateMock());
+    AnonWallet anon(wallet, "anonwallet", std::shared_ptr<WalletDatabase>(WalletDatabase::CreateMock()));
+    LOCK2(cs_main, wallet->cs_wallet);
+    CheckAnonLedger(anon);
+
+    // Add: a deep record with outputs of each type, one at the tip and an unconfirmed one
+    uint256 hashA = GetRandHash();
+    CTransactionRecord rtxA;
+    rtxA.blockHash = chainActive[10]->GetBlockHash();
+    rtxA.nIndex = 1;
+    COutputRecord rA0 = OwnedOutput(0, OUTPUT_RINGCT, 5 * COIN), rA1 = OwnedOutput(1, OUTPUT_CT, 3 * COIN), rA2 = OwnedOutput(2, OUTPUT_STANDARD, 2 * COIN);
+    rtxA.InsertOutput(rA0);
+    rtxA.InsertOutput(rA1);
+    rtxA.InsertOutput(rA2);
+    BOOST_CHECK(anon.SaveRecord(hashA, rtxA));
+
+    uint256 hashB = GetRandHash();
+    CTransactionRecord rtxB;
+    rtxB.blockHash = chainActive.Tip()->GetBlockHash();
+    rtxB.nIndex = 1;
+    COutputRecord rB0 = OwnedOutput(0, OUTPUT_RINGCT, 1 * COIN);
+    rtxB.InsertOutput(rB0);
+    BOOST_CHECK(anon.SaveRecord(hashB, rtxB));
+
+    uint256 hashC = GetRandHash();
+    CTransactionRecord rtxC;
+    COutputRecord rC0 = OwnedOutput(0, OUTPUT_STANDARD, 7 * COIN);
+    rtxC.InsertOutput(rC0);
+    BOOST_CHECK(anon.SaveRecord(hashC, rtxC));
+
+    BOOST_CHECK_EQUAL(anon.GetAnonBalance(), 6 * COIN);
+    BOOST_CHECK_EQUAL(anon.GetAnonBalance(12), 5 * COIN);
+    CheckAnonLedger(anon);
+
+    // Spend the RingCT output of A
+    uint256 hashD = GetRandHash();
+    CTransactionRecord rtxD;
+    rtxD.blockHash = chainActive[50]->GetBlockHash();
+    rtxD.nIndex = 1;
+    rtxD.vin.emplace_back(hashA, 0);
+    COutputRecord rD0 = OwnedOutput(0, OUTPUT_RINGCT, 4 * COIN);
+    rtxD.InsertOutput(rD0);
+    anon.AddToSpends(COutPoint(hashA, 0), hashD);
+    BOOST_CHECK(anon.SaveRecord(hashD, rtxD));
+    BOOST_CHECK_EQUAL(anon.GetAnonBalance(), 5 * COIN);
+    CheckAnonLedger(anon);
+
+    // Conflict the spend, which makes the output of A unspent again
+    rtxD.nIndex = -1;
+    rtxD.blockHash = chainActive[60]->GetBlockHash();
+    BOOST_CHECK(anon.SaveRecord(hashD, rtxD));
+    BOOST_CHECK_EQUAL(anon.GetAnonBalance(), 10 * COIN);
+    CheckAnonLedger(anon);
+
+    // Reorg: B leaves the main chain, then the block that conflicted D
+    CValidationState state;
+    BOOST_CHECK(InvalidateBlock(state, Params(), chainActive.Tip()));
+    BOOST_CHECK_EQUAL(anon.GetAnonBalance(), 9 * COIN);
+    CheckAnonLedger(anon);
+
+    BOOST_CHECK(InvalidateBlock(state, Params(), chainActive[55]));
+    CheckAnonLedger(anon);
+
+    // A record added on the new chain
+    uint256 hashE = GetRandHash();
+    CTransactionRecord rtxE;
+    rtxE.blockHash = chainActive.Tip()->GetBlockHash();
+    rtxE.nIndex = 1;
+    COutputRecord rE0 = OwnedOutput(0, OUTPUT_CT, 8 * COIN);
+    rtxE.InsertOutput(rE0);
+    BOOST_CHECK(anon.SaveRecord(hashE, rtxE));
+    CheckAnonLedger(anon);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1383,25 +1383,30 @@ void CWallet::TransactionRemovedFromMempool(const CTransactionRef &ptx) {
 }
 
 void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex *pindex, const std::vector<CTransactionRef>& vtxConflicted) {
-    LOCK2(cs_main, cs_wallet);
-    // TODO: Temporarily ensure that mempool removals are notified before
-    // connected transactions.  This shouldn't matter, but the abandoned
-    // state of transactions in our wallet is currently cleared when we
-    // receive another notification and there is a race condition where
-    // notification of a connected conflict might cause an outside process
-    // to abandon a transaction and then have it inadvertently cleared by
-    // the notification that the conflicted transaction was evicted.
-
-    for (const CTransactionRef& ptx : vtxConflicted) {
-        SyncTransaction(ptx);
-        TransactionRemovedFromMempool(ptx);
-    }
-    for (size_t i = 0; i < pblock->vtx.size(); i++) {
-        SyncTransaction(pblock->vtx[i], pindex, i);
-        TransactionRemovedFromMempool(pblock->vtx[i]);
-    }
+    //Stealth ECDH is done on several threads before cs_wallet is held for the whole block
+    pAnonWalletMain->PrescanStealthOutputs(pblock->vtx);
+    {
+        LOCK2(cs_main, cs_wallet);
+        // TODO: Temporarily ensure that mempool removals are notified before
+        // connected transactions.  This shouldn't matter, but the abandoned
+        // state of transactions in our wallet is currently cleared when we
+        // receive another notification and there is a race condition where
+        // notification of a connected conflict might cause an outside process
+        // to abandon a transaction and then have it inadvertently cleared by
+        // the notification that the conflicted transaction was evicted.
+
+        for (const CTransactionRef& ptx : vtxConflicted) {
+            SyncTransaction(ptx);
+            TransactionRemovedFromMempool(ptx);
+        }
+        for (size_t i = 0; i < pblock->vtx.size(); i++) {
+            SyncTransaction(pblock->vtx[i], pindex, i);
+            TransactionRemovedFromMempool(pblock->vtx[i]);
+        }
+        pAnonWalletMain->ClearStealthPrescan();
 
-    m_last_block_processed = pindex;
+        m_last_block_processed = pindex;
+    }
 }
 
 void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) {
@@ -2156,10 +2161,12 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
 
             CBlock block;
             if (ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+                pAnonWalletMain->PrescanStealthOutputs(block.vtx);
                 LOCK2(cs_main, cs_wallet);
                 if (pindex && !chainActive.Contains(pindex)) {
                     // Abort scan if current block is no longer active, to prevent
                     // marking transactions as coming from the wrong block.
+                    pAnonWalletMain->ClearStealthPrescan();
                     ret = pindex;
                     break;
                 }
@@ -2181,6 +2188,7 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
                     }
                     SyncTransaction(block.vtx[posInBlock], pindex, posInBlock, fUpdate);
                 }
+                pAnonWalletMain->ClearStealthPrescan();
             } else {
                 ret = pindex;
             }
@@ -3877,21 +3885,16 @@ bool CWallet::CreateCoinStake(const CBlockIndex* pindexBest, unsigned int nBits,
     CAmount nCredit = 0;
     CScript scriptPubKeyKernel;
     bool fKernelFound = false;
+    auto nTimeMinBlock = std::max(pindexBest->GetBlockTime() - MAX_PAST_BLOCK_TIME, pindexBest->GetMedianTimePast());
+    std::vector<StakeKernelCandidate> vCandidates;
     for (std::unique_ptr<ZerocoinStake>& stakeInput : listInputs) {
-        // Make sure the wallet is unlocked and shutdown hasn't been requested
-        if (IsLocked() || ShutdownRequested())
-            return false;
-
         CBlockIndex *pindexFrom = stakeInput->GetIndexFrom();
         if (!pindexFrom || pindexFrom->nHeight < 1) {
             LogPrintf("*** no pindexfrom\n");
             continue;
         }
 
-        // Read block header
-        uint256 hashProofOfStake;
         nTxNewTime = GetAdjustedTime();
-        auto nTimeMinBlock = std::max(pindexBest->GetBlockTime() - MAX_PAST_BLOCK_TIME, pindexBest->GetMedianTimePast());
         if (nTxNewTime < nTimeMinBlock)
             nTxNewTime = nTimeMinBlock + 1;
 
@@ -3900,9 +3903,22 @@ bool CWallet::CreateCoinStake(const CBlockIndex* pindexBest, unsigned int nBits,
             continue;
         }
 
-        //iterates each utxo inside of CheckStakeKernelHash()
-        bool fWeightStake = true;
-        if (Stake(stakeInput.get(), nBits, pindexFrom->GetBlockTime(), nTxNewTime, pindexBest, hashProofOfStake, fWeightStake)) {
+        vCandidates.emplace_back(stakeInput.get(), pindexFrom->GetBlockTime(), nTxNewTime);
+    }
+
+    // The kernel search is spread over -stakingthreads threads, and returns as soon as one input hits
+    int nThreads = gArgs.GetArg("-stakingthreads", DEFAULT_STAKING_THREADS);
+    size_t nCandidate = 0;
+    uint256 hashProofOfStake;
+    bool fWeightStake = true;
+    // Make sure the wallet is unlocked and shutdown hasn't been requested, before each input is searched
+    auto fnInterrupt = [this]() { return IsLocked() || ShutdownRequested(); };
+    while (!fKernelFound) {
+        if (fnInterrupt())
+            return false;
+
+        if (SearchStakeKernels(vCandidates, nBits, pindexBest, fWeightStake, nThreads, fnInterrupt, nCandidate, nTxNewTime, hashProofOfStake)) {
+            auto* stakeInput = (ZerocoinStake*)vCandidates[nCandidate].stakeInput;
             int nHeight = 0;
             {
                 LOCK(cs_main);
@@ -3961,15 +3977,15 @@ bool CWallet::CreateCoinStake(const CBlockIndex* pindexBest, unsigned int nBits,
             txNew.vin.emplace_back(in);
 
             //Mark mints as spent
-            auto* z = (ZerocoinStake*)stakeInput.get();
-            if (!z->MarkSpent(this, txNew.GetHash()))
+            if (!stakeInput->MarkSpent(this, txNew.GetHash()))
                 return error("%s: failed to mark mint as used\n", __func__);
 
             fKernelFound = true;
             break;
         }
-        if (fKernelFound)
-            break; // if kernel is found stop searching
+
+        // every input was searched without a kernel, or a new block came in
+        break;
     }
     return fKernelFound;
 }